@@ -0,0 +1,107 @@
+#include "adpcm.h"
+
+static const int8_t kIndexTable[16] = {
+  -1, -1, -1, -1, 2, 4, 6, 8,
+  -1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+static const int16_t kStepTable[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+  253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+  1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+  3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+  12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static inline int clampIndex(int idx) {
+  return idx < 0 ? 0 : (idx > 88 ? 88 : idx);
+}
+
+static inline int32_t clamp16(int32_t v) {
+  return v < -32768 ? -32768 : (v > 32767 ? 32767 : v);
+}
+
+// Apply one 4-bit code to the predictor/index pair (shared by encoder and decoder)
+static inline void imaStep(uint8_t code, int32_t &pred, int &idx) {
+  const int32_t step = kStepTable[idx];
+  int32_t diff = step >> 3;
+  if (code & 4) diff += step;
+  if (code & 2) diff += step >> 1;
+  if (code & 1) diff += step >> 2;
+  pred = clamp16((code & 8) ? pred - diff : pred + diff);
+  idx = clampIndex(idx + kIndexTable[code]);
+}
+
+static inline uint8_t imaEncodeSample(int32_t sample, int32_t &pred, int &idx) {
+  int32_t step = kStepTable[idx];
+  int32_t diff = sample - pred;
+  uint8_t code = 0;
+  if (diff < 0) {
+    code = 8;
+    diff = -diff;
+  }
+  if (diff >= step) { code |= 4; diff -= step; }
+  step >>= 1;
+  if (diff >= step) { code |= 2; diff -= step; }
+  step >>= 1;
+  if (diff >= step) { code |= 1; }
+  imaStep(code, pred, idx);
+  return code;
+}
+
+void ima_encodeBlock(const int16_t *pcm, uint8_t *out, ImaState &st) {
+  int32_t pred = pcm[0];
+  int idx = clampIndex(st.index);
+  out[0] = (uint8_t)(pred & 0xFF);
+  out[1] = (uint8_t)((pred >> 8) & 0xFF);
+  out[2] = (uint8_t)idx;
+  out[3] = 0;
+  for (int i = 0; i < (IMA_BLOCK_BYTES - 4); ++i) {
+    const uint8_t lo = imaEncodeSample(pcm[1 + 2 * i], pred, idx);
+    const uint8_t hi = imaEncodeSample(pcm[2 + 2 * i], pred, idx);
+    out[4 + i] = (uint8_t)(lo | (hi << 4));
+  }
+  st.index = (uint8_t)idx;
+}
+
+void ima_decodeBlock(const uint8_t *in, int16_t *pcm) {
+  int32_t pred = (int16_t)(in[0] | (in[1] << 8));
+  int idx = clampIndex(in[2]);
+  pcm[0] = (int16_t)pred;
+  for (int i = 0; i < (IMA_BLOCK_BYTES - 4); ++i) {
+    imaStep(in[4 + i] & 0x0F, pred, idx);
+    pcm[1 + 2 * i] = (int16_t)pred;
+    imaStep(in[4 + i] >> 4, pred, idx);
+    pcm[2 + 2 * i] = (int16_t)pred;
+  }
+}
+
+static void put16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put32(uint8_t *p, uint32_t v) { put16(p, (uint16_t)v); put16(p + 2, (uint16_t)(v >> 16)); }
+
+void wav_writeImaHeader(uint8_t *out, uint32_t sampleRate, uint32_t dataBytes, uint32_t samples) {
+  const uint32_t byteRate = (uint32_t)((uint64_t)sampleRate * IMA_BLOCK_BYTES / IMA_SAMPLES_PER_BLOCK);
+  uint8_t *p = out;
+  p[0] = 'R'; p[1] = 'I'; p[2] = 'F'; p[3] = 'F';
+  put32(p + 4, WAV_IMA_HEADER_SIZE - 8 + dataBytes);
+  p[8] = 'W'; p[9] = 'A'; p[10] = 'V'; p[11] = 'E';
+  p += 12;
+  p[0] = 'f'; p[1] = 'm'; p[2] = 't'; p[3] = ' ';
+  put32(p + 4, 20);
+  put16(p + 8, 0x0011);           // WAVE_FORMAT_IMA_ADPCM
+  put16(p + 10, 1);               // mono
+  put32(p + 12, sampleRate);
+  put32(p + 16, byteRate);
+  put16(p + 20, IMA_BLOCK_BYTES); // block align
+  put16(p + 22, 4);               // bits per sample
+  put16(p + 24, 2);               // extra format bytes
+  put16(p + 26, IMA_SAMPLES_PER_BLOCK);
+  p += 28;
+  p[0] = 'f'; p[1] = 'a'; p[2] = 'c'; p[3] = 't';
+  put32(p + 4, 4);
+  put32(p + 8, samples);
+  p += 12;
+  p[0] = 'd'; p[1] = 'a'; p[2] = 't'; p[3] = 'a';
+  put32(p + 4, dataBytes);
+}
@@ -0,0 +1,24 @@
+// IMA-ADPCM (WAV format 0x11) block codec and WAV header helpers
+// Portable (no Arduino dependencies); used by the clip recorder and host tools.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Mono block layout: 4-byte header (first sample + step index) then 4-bit codes
+#define IMA_BLOCK_BYTES       256
+#define IMA_SAMPLES_PER_BLOCK 505  // 1 header sample + 2 per payload byte
+#define WAV_IMA_HEADER_SIZE   60   // RIFF + fmt(20) + fact + data chunk headers
+
+// Step index carried from block to block (predictor restarts at each block header)
+struct ImaState {
+  uint8_t index;
+};
+
+// Encode IMA_SAMPLES_PER_BLOCK samples into one IMA_BLOCK_BYTES block
+void ima_encodeBlock(const int16_t *pcm, uint8_t *out, ImaState &st);
+// Decode one block back into IMA_SAMPLES_PER_BLOCK samples
+void ima_decodeBlock(const uint8_t *in, int16_t *pcm);
+
+// Write a mono IMA-ADPCM WAV header; dataBytes/samples may be patched later
+void wav_writeImaHeader(uint8_t *out, uint32_t sampleRate, uint32_t dataBytes, uint32_t samples);
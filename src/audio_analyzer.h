@@ -0,0 +1,325 @@
+// Compile-time specialized spectrum analyzer for 24-bit I2S microphone frames
+// Portable (no Arduino dependencies) so it can be checked on the host.
+//
+// AudioAnalyzer<SampleRate, N, BandTable> precomputes everything that depends
+// only on the configuration as constexpr tables: band bin ranges and their
+// normalization, the Hann window, twiddle factors and the bit-reversal order.
+// They live in rodata (flash), so no trig or setup work happens per wake and
+// several configurations can coexist in one image. The transform is a float
+// radix-2 FFT of the real frame packed into N/2 complex points; magnitudes are
+// only produced for the bins the band table needs.
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+// ---------------- constexpr math ----------------
+
+constexpr double kAnalyzerPi = 3.14159265358979323846;
+
+// sin(x) for any x: reduce to [-pi/2, pi/2], then Taylor series
+constexpr double ct_sin(double x) {
+  const double twoPi = 2.0 * kAnalyzerPi;
+  x -= twoPi * (double)(int64_t)(x / twoPi);
+  if (x > kAnalyzerPi) x -= twoPi;
+  if (x < -kAnalyzerPi) x += twoPi;
+  if (x > kAnalyzerPi / 2) x = kAnalyzerPi - x;
+  if (x < -kAnalyzerPi / 2) x = -kAnalyzerPi - x;
+  double term = x, sum = x;
+  for (int i = 1; i < 12; ++i) {
+    term *= -x * x / (double)((2 * i) * (2 * i + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double ct_cos(double x) {
+  return ct_sin(x + kAnalyzerPi / 2);
+}
+
+constexpr int ct_log2(uint32_t n) {
+  int bits = 0;
+  while ((1UL << bits) < n) ++bits;
+  return bits;
+}
+
+// ---------------- band tables ----------------
+
+// A BandTable type provides: static constexpr int count; and
+// static constexpr uint16_t low[count], high[count] (Hz, inclusive ranges).
+// HiveSync's ten 98-586 Hz bands:
+struct HiveBandTable {
+  static constexpr int count = 10;
+  static constexpr uint16_t low[count]  = {  98, 146, 195, 244, 293, 342, 391, 439, 488, 537 };
+  static constexpr uint16_t high[count] = { 146, 195, 244, 293, 342, 391, 439, 488, 537, 586 };
+};
+
+// Bin ranges [start, end] with 1/bins normalization
+template <int Count>
+struct AnalyzerBins {
+  int start[Count] = {};
+  int end[Count] = {};
+  float norm[Count] = {};
+};
+
+// Band edges (Hz) to FFT bins for one sample rate / size
+template <uint32_t SampleRate, int N>
+struct AnalyzerBinMath {
+  // First bin at or above num/den Hz, last bin at or below it
+  static constexpr int binCeil(uint64_t num, uint64_t den) {
+    return (int)((num * N + den * SampleRate - 1) / (den * SampleRate));
+  }
+  static constexpr int binFloor(uint64_t num, uint64_t den) {
+    return (int)((num * N) / (den * SampleRate));
+  }
+  template <int Count>
+  static constexpr void set(AnalyzerBins<Count> &t, int b, int s, int e) {
+    if (s < 1) s = 1;  // skip DC
+    if (e > N / 2 - 1) e = N / 2 - 1;
+    if (e < s) e = s;
+    t.start[b] = s;
+    t.end[b] = e;
+    t.norm[b] = 1.0f / (float)(e - s + 1);
+  }
+
+  template <typename BandTable>
+  static constexpr AnalyzerBins<BandTable::count> bands() {
+    AnalyzerBins<BandTable::count> t;
+    for (int b = 0; b < BandTable::count; ++b) {
+      set(t, b, binCeil(BandTable::low[b], 1), binFloor(BandTable::high[b], 1));
+    }
+    return t;
+  }
+
+  // The table's whole span split into Parts equal-width bands
+  template <typename BandTable, int Parts>
+  static constexpr AnalyzerBins<Parts> spanSplit() {
+    AnalyzerBins<Parts> t;
+    const uint64_t lo = BandTable::low[0];
+    const uint64_t width = BandTable::high[BandTable::count - 1] - lo;
+    for (int b = 0; b < Parts; ++b) {
+      set(t, b, binCeil(lo * Parts + width * b, Parts), binCeil(lo * Parts + width * (b + 1), Parts) - 1);
+    }
+    return t;
+  }
+};
+
+// Per-size FFT tables, shared by every configuration with the same N
+template <int N>
+struct AnalyzerTables {
+  static constexpr int kHalf = N / 2;
+  static_assert(kHalf <= 65536, "bit-reversal table is 16-bit");
+  float cosTab[kHalf] = {};    // cos(2*pi*k/N); twiddle W_N^k = cos - i*sin
+  float sinTab[kHalf] = {};
+  float window[kHalf] = {};    // symmetric Hann over N points, first half
+  uint16_t bitrev[kHalf] = {}; // bit-reversal order for the N/2-point transform
+  constexpr AnalyzerTables() {
+    const int bits = ct_log2(kHalf);
+    for (int k = 0; k < kHalf; ++k) {
+      const double a = 2.0 * kAnalyzerPi * (double)k / (double)N;
+      cosTab[k] = (float)ct_cos(a);
+      sinTab[k] = (float)ct_sin(a);
+      // Symmetric, uncompensated Hann: band magnitudes keep their historical scale
+      window[k] = (float)(0.5 - 0.5 * ct_cos(2.0 * kAnalyzerPi * (double)k / (double)(N - 1)));
+      int r = 0;
+      for (int i = 0; i < bits; ++i) r |= ((k >> i) & 1) << (bits - 1 - i);
+      bitrev[k] = (uint16_t)r;
+    }
+  }
+};
+
+template <int N>
+inline constexpr AnalyzerTables<N> kAnalyzerTables{};
+
+// Spectrum of the window itself, W[k] = sum_i w(i) e^(-2*pi*j*k*i/N), for the
+// first Bins bins. A frame's DC (mean) contributes mean * W[k] to bin k, so it
+// can be removed after the transform. Closed form: the symmetric Hann is
+// 0.5 - 0.25 (e^(j*phi*i) + e^(-j*phi*i)) with phi = 2*pi/(N-1), and each term
+// is a geometric series G(a) = e^(j*a*(N-1)/2) * sin(a*N/2) / sin(a/2).
+template <int N, int Bins>
+struct AnalyzerWindowSpectrum {
+  float re[Bins] = {};
+  float im[Bins] = {};
+  static constexpr void addSeries(double a, double scale, double &re, double &im) {
+    const double d = ct_sin(a / 2);
+    const double amp = (d > -1e-12 && d < 1e-12) ? (double)N : ct_sin(a * N / 2) / d;
+    re += scale * amp * ct_cos(a * (N - 1) / 2);
+    im += scale * amp * ct_sin(a * (N - 1) / 2);
+  }
+  constexpr AnalyzerWindowSpectrum() {
+    const double phi = 2.0 * kAnalyzerPi / (double)(N - 1);
+    for (int k = 0; k < Bins; ++k) {
+      const double theta = 2.0 * kAnalyzerPi * (double)k / (double)N;
+      double r = 0.0, i = 0.0;
+      addSeries(-theta, 0.5, r, i);
+      addSeries(phi - theta, -0.25, r, i);
+      addSeries(-phi - theta, -0.25, r, i);
+      re[k] = (float)r;
+      im[k] = (float)i;
+    }
+  }
+};
+
+// ---------------- analyzer ----------------
+
+template <uint32_t SampleRate, int N, typename BandTable>
+class AudioAnalyzer {
+ public:
+  static_assert(N >= 16 && (N & (N - 1)) == 0, "N must be a power of two");
+  static_assert(BandTable::count > 0, "band table is empty");
+
+  static constexpr int kN = N;
+  static constexpr int kBands = BandTable::count;
+  static constexpr uint32_t kSampleRate = SampleRate;
+  static constexpr float kBinHz = (float)SampleRate / (float)N;
+  static constexpr float kFrameMs = 1000.0f * (float)N / (float)SampleRate;
+  // Caller-provided scratch sizes (floats)
+  static constexpr int kWorkFloats = N;
+
+ private:
+  static constexpr int kHalf = N / 2;  // complex points in the packed transform
+  using Bins = AnalyzerBinMath<SampleRate, N>;
+
+ public:
+  static constexpr AnalyzerBins<kBands> kBandBins = Bins::template bands<BandTable>();
+  // Whole span covered by the band table
+  static constexpr int kSpanStart = kBandBins.start[0];
+  static constexpr int kSpanEnd = kBandBins.end[kBands - 1];
+  // Magnitudes are valid for bins [0, kMagBins): the span plus one neighbour
+  // for peak interpolation
+  static constexpr int kMagBins = (kSpanEnd + 2 < kHalf) ? kSpanEnd + 2 : kHalf;
+  static constexpr AnalyzerWindowSpectrum<N, kMagBins> kWindowSpectrum{};
+
+  // The span split into Parts equal-width bands (e.g. spectrogram rows)
+  template <int Parts>
+  static constexpr AnalyzerBins<Parts> spanSplit() {
+    return Bins::template spanSplit<BandTable, Parts>();
+  }
+
+ private:
+  static constexpr const AnalyzerTables<N> &kTables = kAnalyzerTables<N>;
+
+ public:
+  // DC-removed, Hann-windowed magnitude spectrum of one frame of N raw I2S
+  // words (24-bit data MSB-aligned in 32 bits). work must hold kWorkFloats;
+  // mag receives kMagBins values (unnormalized |X[k]|).
+  static void analyze(const int32_t *raw, float *work, float *mag) {
+    Loader ld;
+    begin(ld);
+    load(ld, raw, N, work);
+    finish(ld, work, mag);
+  }
+
+  // The same frame fed in pieces as they arrive (e.g. straight from completed
+  // DMA buffers), so no staging copy of the whole frame is needed: begin(),
+  // load() until full(), then finish(). Samples are windowed into work as they
+  // come; the frame mean is only known at the end, so finish() subtracts its
+  // contribution from the spectrum (mean * kWindowSpectrum).
+  struct Loader {
+    int64_t sum;
+    int filled;
+  };
+
+  static void begin(Loader &ld) {
+    ld.sum = 0;
+    ld.filled = 0;
+  }
+
+  // Takes up to count words (fewer if the frame fills up); returns how many
+  static int load(Loader &ld, const int32_t *raw, int count, float *work) {
+    const int take = count < N - ld.filled ? count : N - ld.filled;
+    for (int j = 0; j < take; ++j) {
+      const int i = ld.filled + j;
+      const int32_t s = raw[j] >> 8;
+      ld.sum += s;
+      work[slot(i)] = (float)s * windowAt(i);
+    }
+    ld.filled += take;
+    return take;
+  }
+
+  static bool full(const Loader &ld) {
+    return ld.filled == N;
+  }
+
+  static void finish(const Loader &ld, float *work, float *mag) {
+    const float mean = (float)ld.sum / (float)N;
+
+    fftBitReversed(work);
+
+    // Split the packed result into the real frame's spectrum, less the DC
+    mag[0] = fabsf(work[0] + work[1] - mean * kWindowSpectrum.re[0]);
+    for (int k = 1; k < kMagBins; ++k) {
+      const float ar = work[2 * k], ai = work[2 * k + 1];
+      const float br = work[2 * (kHalf - k)], bi = -work[2 * (kHalf - k) + 1];
+      const float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+      const float orr = 0.5f * (ai - bi), oi = -0.5f * (ar - br);
+      const float c = kTables.cosTab[k], s = kTables.sinTab[k];
+      const float xr = er + c * orr + s * oi - mean * kWindowSpectrum.re[k];
+      const float xi = ei + c * oi - s * orr - mean * kWindowSpectrum.im[k];
+      mag[k] = sqrtf(xr * xr + xi * xi);
+    }
+  }
+
+  // Sum and normalized mean of mag over each band of the table
+  static void bandSums(const float *mag, float sums[kBands], float means[kBands]) {
+    for (int b = 0; b < kBands; ++b) {
+      float acc = 0.0f;
+      for (int k = kBandBins.start[b]; k <= kBandBins.end[b]; ++k) acc += mag[k];
+      sums[b] = acc;
+      means[b] = acc * kBandBins.norm[b];
+    }
+  }
+
+ private:
+  // Even/odd samples are packed as re/im of N/2 complex points, in
+  // bit-reversed order, ready for the transform
+  static int slot(int i) {
+    return 2 * kTables.bitrev[i >> 1] + (i & 1);
+  }
+
+  // Symmetric window: the table holds the first half
+  static float windowAt(int i) {
+    return i < kHalf ? kTables.window[i] : kTables.window[N - 1 - i];
+  }
+
+  // In-place iterative radix-2 DIT FFT over N/2 interleaved complex points
+  // already in bit-reversed order. Stages of length 2 and 4 have trivial
+  // twiddles (1, -i) and are done without multiplies.
+  static void fftBitReversed(float *x) {
+    for (int i = 0; i < kHalf; i += 2) {
+      float *a = x + 2 * i, *b = a + 2;
+      const float tr = b[0], ti = b[1];
+      b[0] = a[0] - tr; b[1] = a[1] - ti;
+      a[0] += tr; a[1] += ti;
+    }
+    if (kHalf >= 4) {
+      for (int i = 0; i < kHalf; i += 4) {
+        float *p = x + 2 * i;
+        // j = 0: twiddle 1
+        float tr = p[4], ti = p[5];
+        p[4] = p[0] - tr; p[5] = p[1] - ti;
+        p[0] += tr; p[1] += ti;
+        // j = 1: twiddle -i, (r, i) * -i = (i, -r)
+        tr = p[7]; ti = -p[6];
+        p[6] = p[2] - tr; p[7] = p[3] - ti;
+        p[2] += tr; p[3] += ti;
+      }
+    }
+    for (int len = 8; len <= kHalf; len <<= 1) {
+      const int half = len / 2;
+      const int step = N / len;  // W_len^j = W_N^(j*N/len)
+      for (int i = 0; i < kHalf; i += len) {
+        float *a = x + 2 * i, *b = a + 2 * half;
+        for (int j = 0; j < half; ++j) {
+          const float c = kTables.cosTab[j * step], s = kTables.sinTab[j * step];
+          const float br = b[2 * j], bi = b[2 * j + 1];
+          const float tr = br * c + bi * s;
+          const float ti = bi * c - br * s;
+          b[2 * j] = a[2 * j] - tr; b[2 * j + 1] = a[2 * j + 1] - ti;
+          a[2 * j] += tr; a[2 * j + 1] += ti;
+        }
+      }
+    }
+  }
+};
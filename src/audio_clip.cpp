@@ -0,0 +1,256 @@
+#include "audio_clip.h"
+
+#include <LittleFS.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include "audio_inmp441.h"
+#include "log.h"
+
+#define CLIP_DECIMATION (I2S_SAMPLE_RATE / CLIP_SAMPLE_RATE)
+static_assert(I2S_SAMPLE_RATE % CLIP_SAMPLE_RATE == 0, "CLIP_SAMPLE_RATE must divide I2S_SAMPLE_RATE");
+static_assert(CLIP_CHUNK_BYTES % IMA_BLOCK_BYTES == 0, "CLIP_CHUNK_BYTES must be a multiple of the ADPCM block");
+
+// Writer runs on the core not used by loop()/capture, below it in priority
+#define CLIP_WRITER_CORE     0
+#define CLIP_WRITER_PRIO     1
+#define CLIP_WRITER_STACK    4096
+#define CLIP_FINALIZE_MS     5000
+
+// Low-pass stage (transposed direct form II)
+struct Biquad {
+  float b0, b1, b2, a1, a2;
+  float z1, z2;
+  void lowpass(float fc, float fs, float q) {
+    const float w0 = 2.0f * (float)PI * fc / fs;
+    const float c = cosf(w0);
+    const float alpha = sinf(w0) / (2.0f * q);
+    const float a0 = 1.0f + alpha;
+    b0 = (1.0f - c) / 2.0f / a0;
+    b1 = (1.0f - c) / a0;
+    b2 = b0;
+    a1 = -2.0f * c / a0;
+    a2 = (1.0f - alpha) / a0;
+    z1 = z2 = 0.0f;
+  }
+  float run(float x) {
+    const float y = b0 * x + z1;
+    z1 = b1 * x - a1 * y + z2;
+    z2 = b2 * x - a2 * y;
+    return y;
+  }
+};
+
+// Message to the writer task; index -1 finalizes the file
+struct ChunkMsg {
+  int8_t index;
+  uint16_t len;
+};
+
+static File s_file;
+static bool s_open = false;     // writer task alive and owning s_file
+static bool s_closing = false;  // audio_clip_end ran; waiting for the writer to finish
+static bool s_finQueued = false;
+static volatile bool s_active = false;
+static uint32_t s_targetSamples = 0;
+static uint32_t s_produced = 0;
+
+// Double buffer: capture fills one while the writer programs the other
+static uint8_t s_chunk[2][CLIP_CHUNK_BYTES];
+static volatile bool s_chunkBusy[2] = {false, false};
+static int s_fill = 0;
+static size_t s_fillBytes = 0;
+
+static int16_t s_block[IMA_SAMPLES_PER_BLOCK];
+static int s_blockCount = 0;
+static ImaState s_ima = {0};
+static Biquad s_lp[2];
+static float s_dcIn = 0.0f, s_dcOut = 0.0f;
+static uint32_t s_phase = 0;
+// bytes/maxWriteMs belong to the writer task, the rest to the capture side.
+// The writer updates its fields, and audio_clip_end copies the struct while
+// the writer may still run (timeout), under s_statsMux.
+static AudioClipStats s_stats;
+static portMUX_TYPE s_statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+static QueueHandle_t s_queue = nullptr;
+static SemaphoreHandle_t s_done = nullptr;
+
+static void writerTask(void *) {
+  ChunkMsg msg;
+  for (;;) {
+    if (xQueueReceive(s_queue, &msg, portMAX_DELAY) != pdTRUE) continue;
+    if (msg.index < 0) break;
+    const uint32_t t0 = millis();
+    const size_t written = s_file.write(s_chunk[msg.index], msg.len);
+    const uint32_t dt = millis() - t0;
+    portENTER_CRITICAL(&s_statsMux);
+    if (dt > s_stats.maxWriteMs) s_stats.maxWriteMs = dt;
+    s_stats.bytes += written;
+    portEXIT_CRITICAL(&s_statsMux);
+    s_chunkBusy[msg.index] = false;
+  }
+  // Patch sizes now that the payload length is known (samples is final: the
+  // finalize message is queued after the last block)
+  uint8_t hdr[WAV_IMA_HEADER_SIZE];
+  wav_writeImaHeader(hdr, CLIP_SAMPLE_RATE, s_stats.bytes, s_stats.samples);
+  s_file.seek(0);
+  s_file.write(hdr, sizeof(hdr));
+  s_file.close();
+  xSemaphoreGive(s_done);
+  vTaskDelete(nullptr);
+}
+
+static void submitChunk(TickType_t wait) {
+  if (s_fillBytes == 0) return;
+  ChunkMsg msg = {(int8_t)s_fill, (uint16_t)s_fillBytes};
+  s_chunkBusy[s_fill] = true;
+  if (xQueueSend(s_queue, &msg, wait) != pdTRUE) {
+    s_chunkBusy[s_fill] = false;
+    s_stats.droppedBlocks += s_fillBytes / IMA_BLOCK_BYTES;
+    s_fillBytes = 0;
+    return;
+  }
+  s_fill ^= 1;
+  s_fillBytes = 0;
+}
+
+// Encode the current block (padding a short final block) into the fill buffer
+static void emitBlock(int count, TickType_t wait) {
+  for (int i = count; i < IMA_SAMPLES_PER_BLOCK; ++i) s_block[i] = s_block[count - 1];
+  s_blockCount = 0;
+  if (s_chunkBusy[s_fill]) {
+    // Writer still owns this buffer (flash stall): drop rather than block capture
+    s_stats.droppedBlocks++;
+    return;
+  }
+  ima_encodeBlock(s_block, &s_chunk[s_fill][s_fillBytes], s_ima);
+  s_fillBytes += IMA_BLOCK_BYTES;
+  s_stats.samples += (uint32_t)count;
+  if (s_fillBytes == CLIP_CHUNK_BYTES) submitChunk(wait);
+}
+
+// Hand the writer its finalize message and wait for it to close the file.
+// Only then is the file, queue and buffer set free for another clip; a writer
+// stuck on flash keeps s_open set until a later call sees it finish.
+static bool finalize(TickType_t wait) {
+  if (!s_finQueued) {
+    const ChunkMsg fin = {-1, 0};
+    if (xQueueSend(s_queue, &fin, wait) != pdTRUE) return false;
+    s_finQueued = true;
+  }
+  if (xSemaphoreTake(s_done, wait) != pdTRUE) return false;
+  s_open = false;
+  s_closing = false;
+  return true;
+}
+
+bool audio_clip_begin(const char *path, uint32_t seconds) {
+  if (seconds == 0) return false;
+  if (s_open && !(s_closing && finalize(0))) {
+    LOG_W("Clip: previous clip still being written");
+    return false;
+  }
+  if (!LittleFS.begin(true)) {
+    LOG_W("Clip: LittleFS mount failed");
+    return false;
+  }
+  s_file = LittleFS.open(path, "w");
+  if (!s_file) {
+    LOG_W("Clip: cannot open %s", path);
+    return false;
+  }
+  uint8_t hdr[WAV_IMA_HEADER_SIZE];
+  wav_writeImaHeader(hdr, CLIP_SAMPLE_RATE, 0, 0);
+  s_file.write(hdr, sizeof(hdr));
+
+  if (!s_queue) s_queue = xQueueCreate(2, sizeof(ChunkMsg));
+  if (!s_done) s_done = xSemaphoreCreateBinary();
+  if (!s_queue || !s_done) {
+    s_file.close();
+    return false;
+  }
+  xQueueReset(s_queue);
+
+  s_stats = {};
+  s_targetSamples = seconds * (uint32_t)CLIP_SAMPLE_RATE;
+  s_produced = 0;
+  s_fill = 0;
+  s_fillBytes = 0;
+  s_chunkBusy[0] = s_chunkBusy[1] = false;
+  s_blockCount = 0;
+  s_ima.index = 0;
+  s_phase = 0;
+  s_dcIn = s_dcOut = 0.0f;
+  // 4th-order Butterworth anti-alias filter at 90% of the output Nyquist
+  const float fc = 0.45f * (float)CLIP_SAMPLE_RATE;
+  s_lp[0].lowpass(fc, (float)I2S_SAMPLE_RATE, 0.5412f);
+  s_lp[1].lowpass(fc, (float)I2S_SAMPLE_RATE, 1.3066f);
+
+  if (xTaskCreatePinnedToCore(writerTask, "clip_wr", CLIP_WRITER_STACK, nullptr, CLIP_WRITER_PRIO,
+                              nullptr, CLIP_WRITER_CORE) != pdPASS) {
+    s_file.close();
+    return false;
+  }
+  s_open = true;
+  s_closing = false;
+  s_finQueued = false;
+  s_active = true;
+  return true;
+}
+
+bool audio_clip_active() {
+  return s_active;
+}
+
+void audio_clip_feed(const int32_t *i2sSamples, size_t count) {
+  if (!s_active) return;
+  const uint32_t t0 = micros();
+  // 24-bit sample to 16-bit PCM, with optional gain
+  const float scale = (float)(1 << CLIP_GAIN_SHIFT) / 256.0f;
+  for (size_t i = 0; i < count; ++i) {
+    const float x = (float)(i2sSamples[i] >> 8);
+    // DC blocker, then anti-alias low-pass at the input rate
+    const float dc = x - s_dcIn + 0.995f * s_dcOut;
+    s_dcIn = x;
+    s_dcOut = dc;
+    const float y = s_lp[1].run(s_lp[0].run(dc));
+    if (++s_phase < CLIP_DECIMATION) continue;
+    s_phase = 0;
+
+    int32_t v = (int32_t)lrintf(y * scale);
+    if (v > 32767) v = 32767;
+    if (v < -32768) v = -32768;
+    s_block[s_blockCount++] = (int16_t)v;
+    if (s_blockCount == IMA_SAMPLES_PER_BLOCK) emitBlock(s_blockCount, 0);
+    if (++s_produced >= s_targetSamples) {
+      s_active = false;
+      break;
+    }
+  }
+  s_stats.encodeUs += micros() - t0;
+}
+
+bool audio_clip_end(AudioClipStats *outStats) {
+  if (!s_open) return false;
+  s_active = false;
+  // Capture is over, so the tail may wait for the writer
+  const TickType_t wait = pdMS_TO_TICKS(CLIP_FINALIZE_MS);
+  if (!s_closing) {
+    s_closing = true;
+    const uint32_t t0 = millis();
+    while (s_chunkBusy[s_fill] && (millis() - t0) < CLIP_FINALIZE_MS) delay(5);
+    if (s_blockCount > 0) emitBlock(s_blockCount, wait);
+    submitChunk(wait);
+  }
+  const bool ok = finalize(wait);
+  if (!ok) LOG_W("Clip: writer did not finish within %u ms", (unsigned)CLIP_FINALIZE_MS);
+  // The writer may still be running (timeout): take a consistent copy
+  if (outStats) {
+    portENTER_CRITICAL(&s_statsMux);
+    *outStats = s_stats;
+    portEXIT_CRITICAL(&s_statsMux);
+  }
+  return ok;
+}
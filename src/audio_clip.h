@@ -0,0 +1,45 @@
+// Audio clip recorder: taps the I2S capture, decimates, IMA-ADPCM encodes and
+// streams WAV to LittleFS through a double-buffered background writer
+#pragma once
+
+#include <Arduino.h>
+#include "adpcm.h"
+
+// Output rate; must divide I2S_SAMPLE_RATE (4000 or 8000 Hz at 16 kHz input)
+#ifndef CLIP_SAMPLE_RATE
+#define CLIP_SAMPLE_RATE 8000
+#endif
+
+// Flash write unit (one sector); each of the two buffers holds this many bytes
+#ifndef CLIP_CHUNK_BYTES
+#define CLIP_CHUNK_BYTES 4096
+#endif
+
+// Digital gain applied to the 24-bit mic samples before 16-bit conversion (as a left shift)
+#ifndef CLIP_GAIN_SHIFT
+#define CLIP_GAIN_SHIFT 0
+#endif
+
+struct AudioClipStats {
+  uint32_t samples;       // samples encoded at CLIP_SAMPLE_RATE
+  uint32_t bytes;         // ADPCM payload bytes written
+  uint32_t droppedBlocks; // ADPCM blocks lost because both buffers were busy
+  uint32_t encodeUs;      // total time spent in audio_clip_feed
+  uint32_t maxWriteMs;    // slowest single flash write
+};
+
+// Start recording up to "seconds" of audio into a new WAV file at path.
+// Mounts LittleFS (formatting on first use) and starts the writer task.
+// Fails while an earlier clip's writer has not yet closed its file.
+bool audio_clip_begin(const char *path, uint32_t seconds);
+
+// True between begin and end while the clip has not reached its length
+bool audio_clip_active();
+
+// Feed raw 32-bit I2S words captured at I2S_SAMPLE_RATE. Never blocks on flash:
+// if both buffers are busy the block is dropped and counted.
+void audio_clip_feed(const int32_t *i2sSamples, size_t count);
+
+// Flush the partial block/chunk, patch the WAV header and close the file.
+// False if the writer did not finish in time; it keeps the file until it does.
+bool audio_clip_end(AudioClipStats *outStats = nullptr);
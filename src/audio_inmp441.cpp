@@ -1,169 +1,208 @@
 #include "audio_inmp441.h"
 
-#include <arduinoFFT.h>
-#include "driver/i2s.h"
 #include "esp_heap_caps.h"
 
-static const uint16_t kBandLow[AUDIO_BANDS]  = {  98, 146, 195, 244, 293, 342, 391, 439, 488, 537 };
-static const uint16_t kBandHigh[AUDIO_BANDS] = { 146, 195, 244, 293, 342, 391, 439, 488, 537, 586 };
-
-// Local helpers
-static bool i2s_setup(uint32_t sample_rate) {
-  // I2S configuration for standard I2S, 32-bit samples, RX only
-  i2s_config_t i2s_config = {};
-  i2s_config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX);
-  i2s_config.sample_rate = sample_rate;
-  i2s_config.bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT;
-  i2s_config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT; // INMP441 with L/R tied to GND -> left channel
-  i2s_config.communication_format = I2S_COMM_FORMAT_STAND_MSB;
-  i2s_config.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1;
-  i2s_config.dma_buf_count = 8;
-  i2s_config.dma_buf_len = 256; // samples per DMA buffer
-  i2s_config.use_apll = false;
-  i2s_config.tx_desc_auto_clear = false;
-  i2s_config.fixed_mclk = 0;
-
-  i2s_pin_config_t pin_config = {};
-  pin_config.bck_io_num = I2S_SCK_PIN;
-  pin_config.ws_io_num = I2S_WS_PIN;
-  pin_config.data_out_num = I2S_PIN_NO_CHANGE; // microphone is input-only
-  pin_config.data_in_num = I2S_SD_PIN;
-
-  if (i2s_driver_install(I2S_NUM_0, &i2s_config, 0, nullptr) != ESP_OK) {
-    return false;
-  }
-  if (i2s_set_pin(I2S_NUM_0, &pin_config) != ESP_OK) {
-    i2s_driver_uninstall(I2S_NUM_0);
-    return false;
-  }
-  // Ensure clock is set (some IDF versions require explicit set after driver install)
-  i2s_set_clk(I2S_NUM_0, sample_rate, I2S_BITS_PER_SAMPLE_32BIT, I2S_CHANNEL_MONO);
-  return true;
-}
+#include "audio_clip.h"
+#include "i2s_capture.h"
+#include "log.h"
+#include "supervisor.h"
 
-static void i2s_teardown() {
-  i2s_driver_uninstall(I2S_NUM_0);
-}
+using Analyzer = AudioAnalyzerMain;
+static_assert(SPECTRO_BANDS <= SPECTRO_MAX_BANDS, "SPECTRO_BANDS exceeds codec limit");
+static constexpr AnalyzerBins<SPECTRO_BANDS> kSpectroBins = Analyzer::spanSplit<SPECTRO_BANDS>();
+static_assert(FFT_N % I2S_DMA_FRAME_NUM == 0, "an FFT frame must be whole DMA buffers");
 
-// Read exactly "count" 32-bit samples from I2S into dest. Blocks until done.
-static void i2s_read_blocking(int32_t* dest, size_t count) {
-  uint8_t* ptr = reinterpret_cast<uint8_t*>(dest);
-  size_t bytes_to_read = count * sizeof(int32_t);
-  size_t total = 0;
-  while (total < bytes_to_read) {
-    size_t br = 0;
-    i2s_read(I2S_NUM_0, ptr + total, bytes_to_read - total, &br, portMAX_DELAY);
-    total += br;
-  }
-}
+// Streaming statistics state (fixed size, reused each capture)
+static BandStatAccumulator s_bandAcc[AUDIO_BANDS];
+static P2Quantile s_peakMedian;
+
+// Spectrogram pooling state
+static SpectroEncoder s_spectroEnc;
+static float s_spectroPool[SPECTRO_BANDS];
 
-bool analyzeINMP441Bins60s(float outBands[AUDIO_BANDS]) {
+bool analyzeINMP441Bins60s(float outBands[AUDIO_BANDS], AudioStats *outStats, AudioSpectrogram *outSpectro) {
   for (int i = 0; i < AUDIO_BANDS; ++i) outBands[i] = 0.0f;
 
-  if (!i2s_setup(I2S_SAMPLE_RATE)) {
+  if (!i2s_capture_begin(I2S_SAMPLE_RATE)) {
     return false;
   }
 
-  // Discard the first ~100ms to stabilize mic/clock
-  {
-    const size_t junk_samples = (I2S_SAMPLE_RATE / 10);
-    int32_t* junk = (int32_t*)heap_caps_malloc(junk_samples * sizeof(int32_t), MALLOC_CAP_8BIT);
-    if (junk) {
-      i2s_read_blocking(junk, junk_samples);
-      free(junk);
-    } else {
-      // Fallback: small stack buffer loop
-      const size_t chunk = 256;
-      int32_t buf[chunk];
-      size_t remain = junk_samples;
-      while (remain) {
-        size_t take = remain > chunk ? chunk : remain;
-        i2s_read_blocking(buf, take);
-        remain -= take;
-      }
+  // Discard the first ~100ms (whole DMA buffers) to stabilize mic/clock
+  size_t count = 0;
+  for (size_t junk = 0; junk < I2S_SAMPLE_RATE / 10; junk += count) {
+    if (!i2s_capture_next(count)) {
+      i2s_capture_end();
+      return false;
     }
   }
 
-  // FFT setup
-  static_assert((FFT_N & (FFT_N - 1)) == 0, "FFT_N must be power of two");
-  const double fs = (double)I2S_SAMPLE_RATE;
-  const double freq_res = fs / (double)FFT_N;
-
-  // Precompute band index ranges
-  int bandStart[AUDIO_BANDS];
-  int bandEnd[AUDIO_BANDS];
-  for (int b = 0; b < AUDIO_BANDS; ++b) {
-    int s = (int)ceil((double)kBandLow[b] / freq_res);
-    int e = (int)floor((double)kBandHigh[b] / freq_res);
-    if (s < 1) s = 1;                // skip DC bin
-    if (e > (FFT_N / 2 - 1)) e = (FFT_N / 2 - 1);
-    if (e < s) e = s;
-    bandStart[b] = s;
-    bandEnd[b] = e;
-  }
-
-  // Allocate FFT buffers
-  double* vReal = (double*)heap_caps_malloc(sizeof(double) * FFT_N, MALLOC_CAP_8BIT);
-  double* vImag = (double*)heap_caps_malloc(sizeof(double) * FFT_N, MALLOC_CAP_8BIT);
-  int32_t* i2sBuf = (int32_t*)heap_caps_malloc(sizeof(int32_t) * FFT_N, MALLOC_CAP_8BIT);
-  if (!vReal || !vImag || !i2sBuf) {
-    if (vReal) free(vReal);
-    if (vImag) free(vImag);
-    if (i2sBuf) free(i2sBuf);
-    i2s_teardown();
+  // Allocate FFT buffers (float scratch; magnitudes only for the bins used).
+  // Each block is windowed straight into work, no frame-sized staging copy.
+  float* work = (float*)heap_caps_malloc(sizeof(float) * Analyzer::kWorkFloats, MALLOC_CAP_8BIT);
+  float* mag = (float*)heap_caps_malloc(sizeof(float) * Analyzer::kMagBins, MALLOC_CAP_8BIT);
+  if (!work || !mag) {
+    if (work) free(work);
+    if (mag) free(mag);
+    i2s_capture_end();
     return false;
   }
-  ArduinoFFT FFT = ArduinoFFT(vReal, vImag, FFT_N, fs);
 
   // Capture/analyze for 60 seconds (may exceed by up to one frame)
   const uint32_t start_ms = millis();
-  const uint32_t limit_ms = 60UL * 1000UL;
+  const uint32_t start_us = micros();
+  const uint32_t limit_ms = AUDIO_CAPTURE_MS;
   uint32_t frames = 0;
+  bool stalled = false;
+  Analyzer::Loader frame;
+  Analyzer::begin(frame);
+  // Frame timing: CPU time per frame and spacing of completed frames
+  uint64_t frameUsTotal = 0;
+  uint32_t frameUs = 0, frameUsMax = 0, lastDoneUs = 0;
+  uint32_t spacingMinUs = UINT32_MAX, spacingMaxUs = 0;
+
+  // Streaming statistics (only when requested)
+  float bandSum[AUDIO_BANDS];
+  float bandMean[AUDIO_BANDS];
+  double centroidSum = 0.0, flatnessSum = 0.0;
+  uint64_t statsUsTotal = 0;
+  if (outStats) {
+    memset(outStats, 0, sizeof(*outStats));
+    for (int b = 0; b < AUDIO_BANDS; ++b) s_bandAcc[b].reset();
+    s_peakMedian.init(0.5f);
+  }
+
+  // Spectrogram: equal-width bands over the same span, whole FFT frames per cell
+  constexpr int cellFrames = (int)(SPECTRO_CELL_MS / Analyzer::kFrameMs + 0.5f);
+  constexpr int framesPerCell = cellFrames < 1 ? 1 : cellFrames;
+  int framesInCell = 0;
+  if (outSpectro) {
+    for (int b = 0; b < SPECTRO_BANDS; ++b) s_spectroPool[b] = 0.0f;
+    SpectroInfo info = {};
+    info.bands = SPECTRO_BANDS;
+    info.cellMs = (uint16_t)(Analyzer::kFrameMs * framesPerCell + 0.5f);
+    info.fLowHz = HiveBandTable::low[0];
+    info.fHighHz = HiveBandTable::high[AUDIO_BANDS - 1];
+    info.dbFloorX10 = (int16_t)(SPECTRO_DB_FLOOR * 10.0f);
+    info.dbStepX100 = (uint8_t)(SPECTRO_DB_STEP * 100.0f + 0.5f);
+    s_spectroEnc.begin(outSpectro->buf, outSpectro->capacity, info);
+  }
 
-  while ((millis() - start_ms) <= limit_ms) {
-    // Read one FFT frame from I2S
-    i2s_read_blocking(i2sBuf, FFT_N);
-
-    // Convert and remove DC (mean)
-    double mean = 0.0;
-    for (int i = 0; i < FFT_N; ++i) {
-      // INMP441 provides 24-bit data in 32-bit word, MSB aligned
-      // Shift to get 24-bit signed sample and scale to double
-      int32_t s = i2sBuf[i] >> 8; // keep top 24 bits
-      vReal[i] = (double)s;
-      mean += vReal[i];
-      vImag[i] = 0.0;
+  while (frame.filled || (millis() - start_ms) <= limit_ms) {
+    // Next DMA buffer's worth of samples
+    const int32_t *block = i2s_capture_next(count);
+    if (!block) {
+      stalled = true;
+      break;
+    }
+    const uint32_t blockUs = micros();
+    supervisor_feed();
+    // Tap raw samples for an armed clip recording (encodes only; flash writes are async)
+    if (audio_clip_active()) audio_clip_feed(block, count);
+
+    // Window the block into the FFT input; frames are whole blocks
+    Analyzer::load(frame, block, (int)count, work);
+    if (!Analyzer::full(frame)) {
+      frameUs += micros() - blockUs;
+      continue;
     }
-    mean /= (double)FFT_N;
-    for (int i = 0; i < FFT_N; ++i) vReal[i] -= mean;
 
-    // Windowing + FFT
-    FFT.windowing(vReal, FFT_N, FFT_WIN_TYP_HANN, FFT_FORWARD);
-    FFT.compute(vReal, vImag, FFT_N, FFT_FORWARD);
-    FFT.complexToMagnitude(vReal, vImag, FFT_N);
+    // DC removal, float FFT and magnitudes of the band span
+    Analyzer::finish(frame, work, mag);
+    Analyzer::begin(frame);
 
     // Aggregate bands over this frame
-    for (int b = 0; b < AUDIO_BANDS; ++b) {
-      double sum = 0.0;
-      for (int k = bandStart[b]; k <= bandEnd[b]; ++k) {
-        sum += vReal[k];
+    Analyzer::bandSums(mag, bandSum, bandMean);
+    for (int b = 0; b < AUDIO_BANDS; ++b) outBands[b] += bandSum[b];
+
+    // Per-frame statistics update (O(1) memory, timed)
+    if (outStats) {
+      const uint32_t t0 = micros();
+      for (int b = 0; b < AUDIO_BANDS; ++b) s_bandAcc[b].add(bandMean[b]);
+      float peakMag = 0.0f;
+      const float peakHz =
+          spectrum_peakHz(mag, Analyzer::kSpanStart, Analyzer::kSpanEnd, Analyzer::kBinHz, &peakMag);
+      s_peakMedian.add(peakHz);
+      if (peakMag > outStats->peakMaxMag) {
+        outStats->peakMaxMag = peakMag;
+        outStats->peakMaxHz = peakHz;
+      }
+      float centroid = 0.0f, flatness = 0.0f;
+      spectrum_centroidFlatness(mag, Analyzer::kSpanStart, Analyzer::kSpanEnd, Analyzer::kBinHz, centroid, flatness);
+      centroidSum += centroid;
+      flatnessSum += flatness;
+      const uint32_t dt = micros() - t0;
+      statsUsTotal += dt;
+      if (dt > outStats->statsUsMax) outStats->statsUsMax = dt;
+    }
+
+    // Pool into spectrogram cells; encode each completed column immediately
+    if (outSpectro) {
+      for (int b = 0; b < SPECTRO_BANDS; ++b) {
+        float sum = 0.0f;
+        for (int k = kSpectroBins.start[b]; k <= kSpectroBins.end[b]; ++k) sum += mag[k];
+        s_spectroPool[b] += sum * kSpectroBins.norm[b];
       }
-      outBands[b] += (float)sum;
+      if (++framesInCell >= framesPerCell) {
+        uint8_t codes[SPECTRO_BANDS];
+        for (int b = 0; b < SPECTRO_BANDS; ++b) {
+          codes[b] = spectro_quantize(s_spectroPool[b] / (float)framesInCell, s_spectroEnc.info());
+          s_spectroPool[b] = 0.0f;
+        }
+        s_spectroEnc.addColumn(codes);
+        framesInCell = 0;
+      }
+    }
+
+    const uint32_t doneUs = micros();
+    frameUs += doneUs - blockUs;
+    frameUsTotal += frameUs;
+    if (frameUs > frameUsMax) frameUsMax = frameUs;
+    frameUs = 0;
+    if (frames) {
+      const uint32_t spacing = doneUs - lastDoneUs;
+      if (spacing < spacingMinUs) spacingMinUs = spacing;
+      if (spacing > spacingMaxUs) spacingMaxUs = spacing;
     }
+    lastDoneUs = doneUs;
     frames++;
   }
 
   // Average over frames and normalize by number of bins per band
   if (frames == 0) frames = 1;
   for (int b = 0; b < AUDIO_BANDS; ++b) {
-    int bins = (bandEnd[b] - bandStart[b] + 1);
-    if (bins < 1) bins = 1;
-    outBands[b] = outBands[b] / (float)frames / (float)bins;
+    outBands[b] = outBands[b] / (float)frames * Analyzer::kBandBins.norm[b];
+  }
+
+  if (outStats) {
+    for (int b = 0; b < AUDIO_BANDS; ++b) s_bandAcc[b].finish(outStats->bands[b]);
+    outStats->peakHz = s_peakMedian.value();
+    outStats->centroidHz = (float)(centroidSum / (double)frames);
+    outStats->flatness = (float)(flatnessSum / (double)frames);
+    outStats->frames = frames;
+    outStats->statsUsPerFrame = (float)statsUsTotal / (float)frames;
+  }
+
+  // A trailing partial cell is dropped so every column has the same duration
+  if (outSpectro) {
+    outSpectro->size = s_spectroEnc.finish();
+    outSpectro->columns = s_spectroEnc.info().columns;
+    outSpectro->truncated = s_spectroEnc.info().truncated;
   }
 
-  free(vReal);
-  free(vImag);
-  free(i2sBuf);
-  i2s_teardown();
-  return true;
+  I2sCaptureStats cap;
+  const uint32_t elapsed_us = micros() - start_us;
+  i2s_capture_end(&cap);
+  // Load: time not spent in i2s_read() (its copy counts as waiting, so the
+  // figure is a lower bound)
+  const float busy = elapsed_us > cap.waitUs ? (float)(elapsed_us - cap.waitUs) : 0.0f;
+  LOG_I("Capture: %lu frames, %lu blocks, CPU load %.1f%%", (unsigned long)frames, (unsigned long)cap.blocks,
+        elapsed_us ? 100.0f * busy / (float)elapsed_us : 0.0f);
+  LOG_I("Frame timing: %lu us avg, %lu us max CPU; completed every %lu-%lu us (nominal %lu)",
+        (unsigned long)(frameUsTotal / frames), (unsigned long)frameUsMax,
+        (unsigned long)(spacingMaxUs ? spacingMinUs : 0), (unsigned long)spacingMaxUs,
+        (unsigned long)(1000000ULL * FFT_N / I2S_SAMPLE_RATE));
+
+  free(work);
+  free(mag);
+  return !stalled;
 }
@@ -3,6 +3,9 @@
 
 #include <Arduino.h>
 #include "pins_config.h"
+#include "audio_analyzer.h"
+#include "audio_stats.h"
+#include "spectro_codec.h"
 
 // I2S pins are defined in pins_config.h (override via build_flags)
 
@@ -15,12 +18,69 @@
 #define FFT_N 4096  // power-of-two, determines frequency resolution
 #endif
 
-// Number of analysis bands (fixed list below)
+// Capture length, and how long a single I2S read may block before the
+// capture is abandoned as stalled
+#define AUDIO_CAPTURE_MS (60UL * 1000UL)
+#ifndef I2S_READ_TIMEOUT_MS
+#define I2S_READ_TIMEOUT_MS 200
+#endif
+
+// Number of analysis bands (fixed list below, HiveBandTable in audio_analyzer.h)
 #define AUDIO_BANDS 10
+static_assert(HiveBandTable::count == AUDIO_BANDS, "band table and AUDIO_BANDS disagree");
+
+// Analyzer configurations; bins, window and twiddles are compile-time tables in
+// flash, so either can be used on any wake without setup cost
+using AudioAnalyzerMain = AudioAnalyzer<I2S_SAMPLE_RATE, FFT_N, HiveBandTable>;
+using AudioAnalyzerProbe = AudioAnalyzer<I2S_SAMPLE_RATE, 1024, HiveBandTable>;  // quick 64 ms look
+
+// Optional streaming statistics gathered alongside the band averages.
+// Per-band values are the per-frame mean bin magnitude (same scale as outBands).
+// Spectral figures cover the full 98-586 Hz span.
+struct AudioStats {
+  AudioBandStats bands[AUDIO_BANDS];
+  float peakHz;          // median dominant peak frequency (parabolic interpolation)
+  float peakMaxHz;       // frequency of the strongest peak seen during the capture
+  float peakMaxMag;      // its magnitude
+  float centroidHz;      // mean spectral centroid
+  float flatness;        // mean spectral flatness (0 = tonal, 1 = noise-like)
+  uint32_t frames;       // FFT frames analyzed
+  float statsUsPerFrame; // measured statistics overhead per frame (average)
+  uint32_t statsUsMax;   // worst-case statistics overhead for a single frame
+};
+
+// Spectrogram mode: 98-586 Hz pooled into SPECTRO_BANDS equal-width bands and
+// ~SPECTRO_CELL_MS columns, quantized to 8-bit log magnitude and encoded as the
+// capture runs (see spectro_codec.h; decode with tools/spectro_decode.cpp)
+#ifndef SPECTRO_BANDS
+#define SPECTRO_BANDS 32
+#endif
+#ifndef SPECTRO_CELL_MS
+#define SPECTRO_CELL_MS 1000
+#endif
+#ifndef SPECTRO_DB_FLOOR
+#define SPECTRO_DB_FLOOR 40.0f  // dB of code 0 (magnitude 100)
+#endif
+#ifndef SPECTRO_DB_STEP
+#define SPECTRO_DB_STEP 0.5f    // dB per code (255 codes span 127.5 dB)
+#endif
+
+// Caller-owned spectrogram output buffer; size/columns/truncated set on return
+struct AudioSpectrogram {
+  uint8_t *buf;
+  size_t capacity;
+  size_t size;
+  uint16_t columns;
+  bool truncated;
+};
 
 // Perform a 60-second capture and FFT-based band aggregation.
 // outBands receives average magnitude per requested band order:
 //  98-146, 146-195, 195-244, 244-293, 293-342,
 //  342-391, 391-439, 439-488, 488-537, 537-586
-// Returns true on success; false if I2S setup fails.
-bool analyzeINMP441Bins60s(float outBands[AUDIO_BANDS]);
+// If outStats is non-null, streaming per-band and spectral statistics are
+// updated per frame at fixed memory cost (no frame storage).
+// If outSpectro is non-null, a compressed spectrogram is written into its buffer.
+// Returns true on success; false if I2S setup fails or the microphone stalls.
+bool analyzeINMP441Bins60s(float outBands[AUDIO_BANDS], AudioStats *outStats = nullptr,
+                           AudioSpectrogram *outSpectro = nullptr);
@@ -0,0 +1,112 @@
+#include "audio_stats.h"
+
+void P2Quantile::init(float p) {
+  p_ = p;
+  count_ = 0;
+}
+
+void P2Quantile::add(float x) {
+  if (count_ < 5) {
+    // Collect the first five observations, then seed the markers from them
+    q_[count_++] = x;
+    if (count_ == 5) {
+      for (int i = 1; i < 5; ++i) {
+        float v = q_[i];
+        int j = i - 1;
+        while (j >= 0 && q_[j] > v) { q_[j + 1] = q_[j]; --j; }
+        q_[j + 1] = v;
+      }
+      for (int i = 0; i < 5; ++i) n_[i] = (float)i;
+      np_[0] = 0.0f;  np_[1] = 2.0f * p_;  np_[2] = 4.0f * p_;  np_[3] = 2.0f + 2.0f * p_;  np_[4] = 4.0f;
+      dn_[0] = 0.0f;  dn_[1] = p_ / 2.0f;  dn_[2] = p_;         dn_[3] = (1.0f + p_) / 2.0f; dn_[4] = 1.0f;
+    }
+    return;
+  }
+
+  // Find the cell k such that q[k] <= x < q[k+1], extending extremes if needed
+  int k;
+  if (x < q_[0]) {
+    q_[0] = x;
+    k = 0;
+  } else if (x >= q_[4]) {
+    q_[4] = x;
+    k = 3;
+  } else {
+    k = 0;
+    while (k < 3 && x >= q_[k + 1]) ++k;
+  }
+  for (int i = k + 1; i < 5; ++i) n_[i] += 1.0f;
+  for (int i = 0; i < 5; ++i) np_[i] += dn_[i];
+
+  // Adjust the three middle markers toward their desired positions
+  for (int i = 1; i <= 3; ++i) {
+    const float d = np_[i] - n_[i];
+    if ((d >= 1.0f && n_[i + 1] - n_[i] > 1.0f) || (d <= -1.0f && n_[i - 1] - n_[i] < -1.0f)) {
+      const int s = d >= 0.0f ? 1 : -1;
+      const float qp = parabolic(i, (float)s);
+      if (q_[i - 1] < qp && qp < q_[i + 1]) {
+        q_[i] = qp;
+      } else {
+        q_[i] = linear(i, s);
+      }
+      n_[i] += (float)s;
+    }
+  }
+  count_++;
+}
+
+float P2Quantile::parabolic(int i, float d) const {
+  return q_[i] + d / (n_[i + 1] - n_[i - 1]) *
+                     ((n_[i] - n_[i - 1] + d) * (q_[i + 1] - q_[i]) / (n_[i + 1] - n_[i]) +
+                      (n_[i + 1] - n_[i] - d) * (q_[i] - q_[i - 1]) / (n_[i] - n_[i - 1]));
+}
+
+float P2Quantile::linear(int i, int d) const {
+  return q_[i] + (float)d * (q_[i + d] - q_[i]) / (n_[i + d] - n_[i]);
+}
+
+float P2Quantile::value() const {
+  if (count_ == 0) return 0.0f;
+  if (count_ >= 5) return q_[2];
+  // Fewer than five samples: exact quantile of what we have
+  float tmp[5];
+  for (uint32_t i = 0; i < count_; ++i) tmp[i] = q_[i];
+  for (uint32_t i = 1; i < count_; ++i) {
+    float v = tmp[i];
+    int j = (int)i - 1;
+    while (j >= 0 && tmp[j] > v) { tmp[j + 1] = tmp[j]; --j; }
+    tmp[j + 1] = v;
+  }
+  uint32_t idx = (uint32_t)(p_ * (float)(count_ - 1) + 0.5f);
+  return tmp[idx];
+}
+
+void BandStatAccumulator::reset() {
+  q10_.init(0.10f);
+  q50_.init(0.50f);
+  q90_.init(0.90f);
+  max_ = 0.0f;
+  mean_ = 0.0;
+  m2_ = 0.0;
+  n_ = 0;
+}
+
+void BandStatAccumulator::add(float x) {
+  q10_.add(x);
+  q50_.add(x);
+  q90_.add(x);
+  if (n_ == 0 || x > max_) max_ = x;
+  n_++;
+  const double delta = (double)x - mean_;
+  mean_ += delta / (double)n_;
+  m2_ += delta * ((double)x - mean_);
+}
+
+void BandStatAccumulator::finish(AudioBandStats &out) const {
+  out.p10 = q10_.value();
+  out.p50 = q50_.value();
+  out.p90 = q90_.value();
+  out.max = max_;
+  out.mean = (float)mean_;
+  out.variance = n_ > 1 ? (float)(m2_ / (double)(n_ - 1)) : 0.0f;
+}
@@ -0,0 +1,103 @@
+// Streaming spectral statistics (fixed memory, updated once per FFT frame)
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+// P-squared (Jain & Chlamtac) single-quantile estimator: 5 markers, no sample storage
+class P2Quantile {
+ public:
+  void init(float p);
+  void add(float x);
+  float value() const;
+  uint32_t count() const { return count_; }
+
+ private:
+  float parabolic(int i, float d) const;
+  float linear(int i, int d) const;
+
+  float p_ = 0.5f;
+  uint32_t count_ = 0;
+  float q_[5];   // marker heights
+  float n_[5];   // actual marker positions
+  float np_[5];  // desired marker positions
+  float dn_[5];  // desired position increments
+};
+
+// Summary of one band over a capture
+struct AudioBandStats {
+  float p10;
+  float p50;
+  float p90;
+  float max;
+  float mean;
+  float variance;
+};
+
+// Per-band accumulator: quantiles via P-squared, mean/variance via Welford
+class BandStatAccumulator {
+ public:
+  void reset();
+  void add(float x);
+  void finish(AudioBandStats &out) const;
+
+ private:
+  P2Quantile q10_, q50_, q90_;
+  float max_ = 0.0f;
+  double mean_ = 0.0;
+  double m2_ = 0.0;
+  uint32_t n_ = 0;
+};
+
+// Dominant peak in mag[start..end] with parabolic interpolation around the
+// maximum bin. Returns frequency in Hz (0 if range empty); peak magnitude via outMag.
+template <typename T>
+float spectrum_peakHz(const T *mag, int start, int end, float binHz, float *outMag = nullptr) {
+  if (end < start) {
+    if (outMag) *outMag = 0.0f;
+    return 0.0f;
+  }
+  int k = start;
+  for (int i = start + 1; i <= end; ++i) {
+    if (mag[i] > mag[k]) k = i;
+  }
+  float delta = 0.0f;
+  float peak = (float)mag[k];
+  // Neighbours may lie outside the search range; they are still valid FFT bins
+  if (k > 0) {
+    const float a = (float)mag[k - 1];
+    const float b = (float)mag[k];
+    const float c = (float)mag[k + 1];
+    const float den = a - 2.0f * b + c;
+    if (den < 0.0f) {
+      delta = 0.5f * (a - c) / den;
+      if (delta > 0.5f) delta = 0.5f;
+      if (delta < -0.5f) delta = -0.5f;
+      peak = b - 0.25f * (a - c) * delta;
+    }
+  }
+  if (outMag) *outMag = peak;
+  return ((float)k + delta) * binHz;
+}
+
+// Spectral centroid (Hz) and flatness (geometric/arithmetic mean, 0..1) over mag[start..end]
+template <typename T>
+void spectrum_centroidFlatness(const T *mag, int start, int end, float binHz,
+                               float &outCentroidHz, float &outFlatness) {
+  outCentroidHz = 0.0f;
+  outFlatness = 0.0f;
+  if (end < start) return;
+  const float eps = 1e-9f;
+  float sum = 0.0f, wsum = 0.0f, logSum = 0.0f;
+  for (int k = start; k <= end; ++k) {
+    const float m = (float)mag[k];
+    sum += m;
+    wsum += m * (float)k;
+    logSum += logf(m + eps);
+  }
+  const int bins = end - start + 1;
+  if (sum <= 0.0f) return;
+  outCentroidHz = (wsum / sum) * binHz;
+  const float arith = sum / (float)bins;
+  outFlatness = expf(logSum / (float)bins) / (arith + eps);
+}
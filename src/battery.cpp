@@ -3,6 +3,8 @@
 #include <Wire.h>
 #include <Adafruit_MAX1704X.h>
 
+#include "log.h"
+
 static Adafruit_MAX17048 g_max17048;
 static bool g_batt_present = false;
 static bool g_batt_inited = false;
@@ -11,13 +13,18 @@ void battery_init() {
   if (g_batt_inited) return;
   g_batt_inited = true;
 
+#ifdef TFT_I2C_POWER
+  // The gauge's I2C pull-ups share the TFT rail; headless wakes never power the display
+  pinMode(TFT_I2C_POWER, OUTPUT);
+  digitalWrite(TFT_I2C_POWER, HIGH);
+#endif
   // Ensure I2C is started; use defaults for this board
   Wire.begin();
   g_batt_present = g_max17048.begin(&Wire);
   if (!g_batt_present) {
-    Serial.println("MAX17048 not detected on I2C (0x36). Battery overlay disabled.");
+    LOG_W("MAX17048 not detected on I2C (0x36). Battery overlay disabled.");
   } else {
-    Serial.println("MAX17048 detected. Battery overlay enabled.");
+    LOG_I("MAX17048 detected. Battery overlay enabled.");
   }
 }
 
@@ -12,6 +12,24 @@
 static Adafruit_ST7789 tft(&SPI, TFT_CS, TFT_DC, TFT_RST);
 static QRcode_ST7789 qrcode(&tft);
 
+// Headless wakes disable the display entirely; otherwise it is brought up on first use
+static bool g_displayEnabled = true;
+static bool g_displayReady = false;
+
+static bool display_ready() {
+  if (!g_displayEnabled) return false;
+  if (!g_displayReady) display_init();
+  return true;
+}
+
+void display_setEnabled(bool enabled) {
+  g_displayEnabled = enabled;
+}
+
+bool display_isEnabled() {
+  return g_displayEnabled;
+}
+
 void display_powerOn() {
 #ifdef TFT_I2C_POWER
   pinMode(TFT_I2C_POWER, OUTPUT);
@@ -22,11 +40,14 @@ void display_powerOn() {
 }
 
 void display_backlight(bool on) {
+  if (!g_displayReady) return;  // never powered this wake; nothing to switch
   pinMode(TFT_BACKLITE, OUTPUT);
   digitalWrite(TFT_BACKLITE, on ? HIGH : LOW);
 }
 
 void display_init() {
+  if (g_displayReady || !g_displayEnabled) return;
+  g_displayReady = true;
   display_powerOn();
   SPI.begin(SCK, MISO, MOSI, SS);
   tft.init(135, 240);
@@ -37,14 +58,17 @@ void display_init() {
 }
 
 void display_fillScreen(uint16_t color) {
+  if (!display_ready()) return;
   tft.fillScreen(color);
 }
 
 void display_fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  if (!display_ready()) return;
   tft.fillRect(x, y, w, h, color);
 }
 
 void display_printAt(const String &text, int16_t y, uint16_t color) {
+  if (!display_ready()) return;
   tft.setTextColor(color);
   int16_t x1, y1;
   uint16_t w, h;
@@ -56,6 +80,7 @@ void display_printAt(const String &text, int16_t y, uint16_t color) {
 }
 
 void display_drawBatteryTopRight() {
+  if (!display_ready()) return;
   float pct = 0.0f, volt = 0.0f;
   if (!battery_read(pct, volt)) {
     return; // no device detected; skip overlay
@@ -88,12 +113,14 @@ void display_drawBatteryTopRight() {
 }
 
 void display_showQR(const String &payload) {
+  if (!display_ready()) return;
   qrcode.init();
   qrcode.create(payload.c_str());
   display_drawBatteryTopRight();
 }
 
 void display_showIP(const IPAddress &ip) {
+  if (!display_ready()) return;
   tft.fillScreen(ST77XX_BLACK);
   display_printAt("HiveSync", TFT_LINE_1, ST77XX_YELLOW);
   display_printAt(ip.toString(), TFT_LINE_2, ST77XX_CYAN);
@@ -101,13 +128,14 @@ void display_showIP(const IPAddress &ip) {
 }
 
 void display_showSensorsAndSleep(float tempC, const char* weightLine) {
+  if (!display_ready()) return;
   tft.fillScreen(ST77XX_BLACK);
   display_printAt("HiveSync", TFT_LINE_1, ST77XX_YELLOW);
   char buf[32];
   snprintf(buf, sizeof(buf), "Temp: %.2f C", tempC);
   display_printAt(String(buf), TFT_LINE_2, ST77XX_WHITE);
   display_printAt(String(weightLine), TFT_LINE_3, ST77XX_WHITE);
-  display_printAt("Sleeping 15 min...", TFT_LINE_4, ST77XX_CYAN);
+  display_printAt("Sleeping...", TFT_LINE_4, ST77XX_CYAN);
   display_drawBatteryTopRight();
 }
 
@@ -13,9 +13,14 @@
 #define TFT_LINE_4  90
 #define TFT_LINE_5  114
 
-// Initialize power, SPI, TFT, and font
+// Initialize power, SPI, TFT, and font (drawing calls do this lazily on first use)
 void display_init();
 
+// Disable for headless wakes: every display call becomes a no-op and the
+// TFT, backlight and SPI are never powered
+void display_setEnabled(bool enabled);
+bool display_isEnabled();
+
 // Power control
 void display_powerOn();
 void display_backlight(bool on);
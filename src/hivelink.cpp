@@ -0,0 +1,244 @@
+#include "hivelink.h"
+
+#include <string.h>
+
+#define HIVELINK_MAGIC0  'H'
+#define HIVELINK_MAGIC1  'L'
+#define HIVELINK_VERSION 1
+
+const uint8_t HIVELINK_BROADCAST[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+// CRC-16/CCITT-FALSE
+static uint16_t crc16(const uint8_t *data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; ++i) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int b = 0; b < 8; ++b) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+size_t hivelink_encode(uint8_t *out, HiveLinkType type, uint16_t seq, const uint8_t *payload, size_t len) {
+  if (len > HIVELINK_MAX_PAYLOAD) return 0;
+  out[0] = HIVELINK_MAGIC0;
+  out[1] = HIVELINK_MAGIC1;
+  out[2] = HIVELINK_VERSION;
+  out[3] = (uint8_t)type;
+  out[4] = (uint8_t)seq;
+  out[5] = (uint8_t)(seq >> 8);
+  out[6] = (uint8_t)len;
+  if (len) memcpy(out + HIVELINK_HEADER_SIZE, payload, len);
+  const size_t n = HIVELINK_HEADER_SIZE + len;
+  const uint16_t crc = crc16(out, n);
+  out[n] = (uint8_t)crc;
+  out[n + 1] = (uint8_t)(crc >> 8);
+  return n + HIVELINK_CRC_SIZE;
+}
+
+bool hivelink_decode(const uint8_t *frame, size_t len, HiveLinkType &type, uint16_t &seq,
+                     const uint8_t *&payload, size_t &payloadLen) {
+  if (len < HIVELINK_HEADER_SIZE + HIVELINK_CRC_SIZE) return false;
+  if (frame[0] != HIVELINK_MAGIC0 || frame[1] != HIVELINK_MAGIC1 || frame[2] != HIVELINK_VERSION) return false;
+  const size_t n = HIVELINK_HEADER_SIZE + frame[6];
+  if (n + HIVELINK_CRC_SIZE != len) return false;
+  const uint16_t crc = (uint16_t)(frame[n] | (frame[n + 1] << 8));
+  if (crc != crc16(frame, n)) return false;
+  type = (HiveLinkType)frame[3];
+  seq = (uint16_t)(frame[4] | (frame[5] << 8));
+  payload = frame + HIVELINK_HEADER_SIZE;
+  payloadLen = frame[6];
+  return true;
+}
+
+// ---------------- Peers ----------------
+
+void HiveLinkPeerCache::clear() {
+  memset(entries_, 0, sizeof(entries_));
+  clock_ = 0;
+}
+
+bool HiveLinkPeerCache::use(const uint8_t mac[6], uint8_t evicted[6], bool &hasEvicted) {
+  hasEvicted = false;
+  Entry *slot = &entries_[0];
+  for (Entry &e : entries_) {
+    if (e.used && memcmp(e.mac, mac, 6) == 0) {
+      e.lastUse = ++clock_;
+      return false;
+    }
+    // Prefer a free slot, else the oldest
+    if (slot->used && (!e.used || e.lastUse < slot->lastUse)) slot = &e;
+  }
+  if (slot->used) {
+    memcpy(evicted, slot->mac, 6);
+    hasEvicted = true;
+  }
+  memcpy(slot->mac, mac, 6);
+  slot->lastUse = ++clock_;
+  slot->used = true;
+  return true;
+}
+
+void HiveLinkPeerCache::forget(const uint8_t mac[6]) {
+  for (Entry &e : entries_) {
+    if (e.used && memcmp(e.mac, mac, 6) == 0) e.used = false;
+  }
+}
+
+bool HiveLinkTransport::usePeer(const uint8_t dstMac[6]) {
+  if (memcmp(dstMac, HIVELINK_BROADCAST, 6) == 0) return true;  // registered by the transport
+  uint8_t evicted[6];
+  bool hasEvicted;
+  if (!peers_.use(dstMac, evicted, hasEvicted)) return true;
+  if (hasEvicted) removePeer(evicted);
+  if (addPeer(dstMac)) return true;
+  peers_.forget(dstMac);
+  return false;
+}
+
+// ---------------- Leaf ----------------
+
+HiveLinkLeaf::HiveLinkLeaf(HiveLinkTransport &t) : t_(t) {
+  memset(gateway_, 0, sizeof(gateway_));
+  memset(ackFrom_, 0, sizeof(ackFrom_));
+  t_.setReceiver(&HiveLinkLeaf::onRecv, this);
+}
+
+HiveLinkLeaf::~HiveLinkLeaf() {
+  t_.setReceiver(nullptr, nullptr);
+}
+
+void HiveLinkLeaf::setGateway(const uint8_t mac[6]) {
+  memcpy(gateway_, mac, 6);
+  hasGateway_ = true;
+}
+
+void HiveLinkLeaf::onRecv(void *ctx, const uint8_t srcMac[6], const uint8_t *data, size_t len) {
+  HiveLinkLeaf *self = static_cast<HiveLinkLeaf *>(ctx);
+  HiveLinkType type;
+  uint16_t seq;
+  const uint8_t *payload;
+  size_t plen;
+  if (!hivelink_decode(data, len, type, seq, payload, plen)) return;
+  if (type != HIVELINK_ACK || seq != self->waitSeq_) return;
+  memcpy(self->ackFrom_, srcMac, 6);
+  self->acked_ = true;
+}
+
+bool HiveLinkLeaf::send(const uint8_t *payload, size_t len, uint16_t seq, uint32_t ackTimeoutMs, uint8_t retries) {
+  uint8_t frame[HIVELINK_MAX_FRAME];
+  const size_t n = hivelink_encode(frame, HIVELINK_DATA, seq, payload, len);
+  attempts_ = 0;
+  if (!n) return false;
+  waitSeq_ = seq;
+  acked_ = false;
+  for (uint8_t attempt = 0; attempt <= retries; ++attempt) {
+    attempts_ = attempt + 1;
+    t_.send(hasGateway_ ? gateway_ : HIVELINK_BROADCAST, frame, n);
+    const uint32_t start = t_.nowMs();
+    while (!acked_ && (t_.nowMs() - start) < ackTimeoutMs) t_.waitMs(1);
+    if (acked_) {
+      if (!hasGateway_) setGateway(ackFrom_);
+      return true;
+    }
+  }
+  return false;
+}
+
+// ---------------- Gateway ----------------
+
+HiveLinkGateway::HiveLinkGateway(HiveLinkTransport &t, HiveLinkSlot *slots, size_t capacity)
+    : t_(t), slots_(slots), cap_(capacity) {
+  memset(seen_, 0, sizeof(seen_));
+  t_.setReceiver(&HiveLinkGateway::onRecv, this);
+}
+
+HiveLinkGateway::~HiveLinkGateway() {
+  t_.setReceiver(nullptr, nullptr);
+}
+
+void HiveLinkGateway::onRecv(void *ctx, const uint8_t srcMac[6], const uint8_t *data, size_t len) {
+  static_cast<HiveLinkGateway *>(ctx)->handle(srcMac, data, len);
+}
+
+void HiveLinkGateway::handle(const uint8_t srcMac[6], const uint8_t *data, size_t len) {
+  HiveLinkType type;
+  uint16_t seq;
+  const uint8_t *payload;
+  size_t plen;
+  if (!hivelink_decode(data, len, type, seq, payload, plen)) {
+    t_.lock();
+    stats_.corrupt++;
+    t_.unlock();
+    return;
+  }
+  if (type != HIVELINK_DATA) return;
+
+  bool ack = false;
+  t_.lock();
+  LeafSeen *leaf = nullptr;
+  for (size_t i = 0; i < HIVELINK_MAX_LEAVES; ++i) {
+    if (seen_[i].used && memcmp(seen_[i].mac, srcMac, 6) == 0) {
+      leaf = &seen_[i];
+      break;
+    }
+  }
+  if (leaf && leaf->lastSeq == seq) {
+    // Our ack was lost and the leaf retried: acknowledge again, store once
+    stats_.duplicates++;
+    ack = true;
+  } else if (plen > HIVELINK_SLOT_PAYLOAD || count_ >= cap_) {
+    stats_.dropped++;
+  } else {
+    HiveLinkSlot &slot = slots_[count_++];
+    memcpy(slot.mac, srcMac, 6);
+    slot.seq = seq;
+    slot.len = (uint8_t)plen;
+    slot.rxMs = t_.nowMs();
+    memcpy(slot.payload, payload, plen);
+    if (!leaf) {
+      leaf = &seen_[seenNext_];
+      seenNext_ = (seenNext_ + 1) % HIVELINK_MAX_LEAVES;
+      memcpy(leaf->mac, srcMac, 6);
+      leaf->used = true;
+    }
+    leaf->lastSeq = seq;
+    stats_.received++;
+    ack = true;
+  }
+  t_.unlock();
+
+  if (ack) {
+    uint8_t frame[HIVELINK_HEADER_SIZE + HIVELINK_CRC_SIZE];
+    const size_t n = hivelink_encode(frame, HIVELINK_ACK, seq, nullptr, 0);
+    if (!t_.send(srcMac, frame, n)) {
+      t_.lock();
+      stats_.ackFailed++;
+      t_.unlock();
+    }
+  }
+}
+
+size_t HiveLinkGateway::takeBatch(HiveLinkSlot *out, size_t maxOut) {
+  t_.lock();
+  const size_t n = count_ < maxOut ? count_ : maxOut;
+  memcpy(out, slots_, n * sizeof(HiveLinkSlot));
+  // Keep anything that did not fit for the next uplink
+  memmove(slots_, slots_ + n, (count_ - n) * sizeof(HiveLinkSlot));
+  count_ -= n;
+  t_.unlock();
+  return n;
+}
+
+size_t HiveLinkGateway::pending() {
+  t_.lock();
+  const size_t n = count_;
+  t_.unlock();
+  return n;
+}
+
+HiveLinkGatewayStats HiveLinkGateway::stats() {
+  t_.lock();
+  const HiveLinkGatewayStats s = stats_;
+  t_.unlock();
+  return s;
+}
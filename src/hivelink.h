@@ -0,0 +1,176 @@
+// HiveLink: leaf -> gateway record delivery (framing, acks, retries, dedup)
+// Portable protocol core; radios plug in through HiveLinkTransport
+// (hivelink_espnow.h on device, hivelink_loopback.h for host simulation).
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HIVELINK_MAX_FRAME    250  // ESP-NOW payload limit
+#define HIVELINK_HEADER_SIZE  7    // magic(2) version type seq(2) len
+#define HIVELINK_CRC_SIZE     2
+#define HIVELINK_MAX_PAYLOAD  (HIVELINK_MAX_FRAME - HIVELINK_HEADER_SIZE - HIVELINK_CRC_SIZE)
+
+// Gateway dedup table size (distinct leaves remembered)
+#ifndef HIVELINK_MAX_LEAVES
+#define HIVELINK_MAX_LEAVES 64
+#endif
+
+// Unicast peers a transport keeps registered with the radio. ESP-NOW allows
+// HIVELINK_RADIO_PEERS in total (broadcast included), far fewer than the
+// leaves of an apiary, so the least recently used peer is removed to make
+// room. Each ack is sent before the next frame is handled, so a few suffice.
+#define HIVELINK_RADIO_PEERS 20  // ESP_NOW_MAX_TOTAL_PEER_NUM
+#ifndef HIVELINK_PEER_SLOTS
+#define HIVELINK_PEER_SLOTS 8
+#endif
+static_assert(HIVELINK_PEER_SLOTS < HIVELINK_RADIO_PEERS, "the broadcast peer needs a radio slot");
+
+// Largest record a gateway batch slot holds
+#ifndef HIVELINK_SLOT_PAYLOAD
+#define HIVELINK_SLOT_PAYLOAD 48
+#endif
+
+enum HiveLinkType : uint8_t {
+  HIVELINK_DATA = 1,
+  HIVELINK_ACK = 2,
+};
+
+extern const uint8_t HIVELINK_BROADCAST[6];
+
+// Least recently used set of unicast peer MACs
+class HiveLinkPeerCache {
+ public:
+  void clear();
+  // Mark mac most recently used. Returns true if it was not cached and must be
+  // registered; evicted (valid when hasEvicted) must be unregistered first.
+  bool use(const uint8_t mac[6], uint8_t evicted[6], bool &hasEvicted);
+  // Drop mac again (its registration failed)
+  void forget(const uint8_t mac[6]);
+
+ private:
+  struct Entry {
+    uint8_t mac[6];
+    uint32_t lastUse;
+    bool used;
+  };
+  Entry entries_[HIVELINK_PEER_SLOTS] = {};
+  uint32_t clock_ = 0;
+};
+
+// Radio abstraction. Receive handlers may run on another task (ESP-NOW runs them
+// on the Wi-Fi task); lock()/unlock() guard state shared with that context.
+// Radios that need unicast peers registered call usePeer() from send(); only
+// one context may send (the leaf's loop, or the gateway's acks).
+class HiveLinkTransport {
+ public:
+  typedef void (*RecvFn)(void *ctx, const uint8_t srcMac[6], const uint8_t *data, size_t len);
+
+  virtual ~HiveLinkTransport() {}
+  virtual bool send(const uint8_t dstMac[6], const uint8_t *data, size_t len) = 0;
+  virtual uint32_t nowMs() = 0;
+  virtual void waitMs(uint32_t ms) = 0;
+  virtual void lock() {}
+  virtual void unlock() {}
+
+  void setReceiver(RecvFn fn, void *ctx) {
+    recv_ = fn;
+    recvCtx_ = ctx;
+  }
+
+ protected:
+  void deliver(const uint8_t srcMac[6], const uint8_t *data, size_t len) {
+    if (recv_) recv_(recvCtx_, srcMac, data, len);
+  }
+
+  // Peer registration with the radio (ESP-NOW); no-ops by default
+  virtual bool addPeer(const uint8_t /*mac*/[6]) { return true; }
+  virtual void removePeer(const uint8_t /*mac*/[6]) {}
+  // Register dstMac if needed, evicting the least recently used unicast peer
+  bool usePeer(const uint8_t dstMac[6]);
+  void clearPeers() { peers_.clear(); }
+
+ private:
+  RecvFn recv_ = nullptr;
+  void *recvCtx_ = nullptr;
+  HiveLinkPeerCache peers_;
+};
+
+// Frame helpers (exposed for tests/tools)
+size_t hivelink_encode(uint8_t *out, HiveLinkType type, uint16_t seq, const uint8_t *payload, size_t len);
+bool hivelink_decode(const uint8_t *frame, size_t len, HiveLinkType &type, uint16_t &seq,
+                     const uint8_t *&payload, size_t &payloadLen);
+
+// Leaf side: send one record and wait for the gateway's ack, retrying on timeout.
+// The first send is broadcast; the acking gateway's MAC is remembered for unicast.
+class HiveLinkLeaf {
+ public:
+  explicit HiveLinkLeaf(HiveLinkTransport &t);
+  ~HiveLinkLeaf();
+
+  void setGateway(const uint8_t mac[6]);
+  void clearGateway() { hasGateway_ = false; }
+  bool hasGateway() const { return hasGateway_; }
+  const uint8_t *gateway() const { return gateway_; }
+
+  // Returns true once acked. seq must change per record (persist it across sleep).
+  bool send(const uint8_t *payload, size_t len, uint16_t seq, uint32_t ackTimeoutMs, uint8_t retries);
+  uint8_t lastAttempts() const { return attempts_; }
+
+ private:
+  static void onRecv(void *ctx, const uint8_t srcMac[6], const uint8_t *data, size_t len);
+
+  HiveLinkTransport &t_;
+  uint8_t gateway_[6];
+  bool hasGateway_ = false;
+  uint16_t waitSeq_ = 0;
+  volatile bool acked_ = false;
+  uint8_t ackFrom_[6];
+  uint8_t attempts_ = 0;
+};
+
+struct HiveLinkSlot {
+  uint8_t mac[6];
+  uint16_t seq;
+  uint8_t len;
+  uint32_t rxMs;  // transport time when received (lets the gateway timestamp it)
+  uint8_t payload[HIVELINK_SLOT_PAYLOAD];
+};
+
+struct HiveLinkGatewayStats {
+  uint32_t received;   // valid data frames
+  uint32_t duplicates; // retransmissions already stored (re-acked)
+  uint32_t dropped;    // batch full or payload too large (not acked)
+  uint32_t ackFailed;  // stored, but the ack could not be sent
+  uint32_t corrupt;    // bad magic/CRC/length
+};
+
+// Gateway side: acks data frames, drops duplicates per leaf, batches payloads
+// into caller-provided fixed slots until the application uplinks and clears them.
+class HiveLinkGateway {
+ public:
+  HiveLinkGateway(HiveLinkTransport &t, HiveLinkSlot *slots, size_t capacity);
+  ~HiveLinkGateway();
+
+  // Copy out the batch under the transport lock; returns entries copied and clears them.
+  size_t takeBatch(HiveLinkSlot *out, size_t maxOut);
+  size_t pending();
+  HiveLinkGatewayStats stats();
+
+ private:
+  struct LeafSeen {
+    uint8_t mac[6];
+    uint16_t lastSeq;
+    bool used;
+  };
+  static void onRecv(void *ctx, const uint8_t srcMac[6], const uint8_t *data, size_t len);
+  void handle(const uint8_t srcMac[6], const uint8_t *data, size_t len);
+
+  HiveLinkTransport &t_;
+  HiveLinkSlot *slots_;
+  size_t cap_;
+  size_t count_ = 0;
+  LeafSeen seen_[HIVELINK_MAX_LEAVES];
+  size_t seenNext_ = 0;  // round-robin eviction when the table is full
+  HiveLinkGatewayStats stats_ = {};
+};
@@ -0,0 +1,83 @@
+#include "hivelink_espnow.h"
+
+#include <WiFi.h>
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include "log.h"
+
+static EspNowTransport *s_active = nullptr;
+
+void EspNowTransport::dispatch(const uint8_t *mac, const uint8_t *data, int len) {
+  if (s_active && mac && len > 0) s_active->deliver(mac, data, (size_t)len);
+}
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+static void onEspNowRecv(const esp_now_recv_info_t *info, const uint8_t *data, int len) {
+  EspNowTransport::dispatch(info ? info->src_addr : nullptr, data, len);
+}
+#else
+static void onEspNowRecv(const uint8_t *mac, const uint8_t *data, int len) {
+  EspNowTransport::dispatch(mac, data, len);
+}
+#endif
+
+static bool ensurePeer(const uint8_t mac[6]) {
+  if (esp_now_is_peer_exist(mac)) return true;
+  esp_now_peer_info_t peer = {};
+  memcpy(peer.peer_addr, mac, 6);
+  peer.channel = 0;  // follow the current radio channel
+  peer.ifidx = WIFI_IF_STA;
+  peer.encrypt = false;
+  return esp_now_add_peer(&peer) == ESP_OK;
+}
+
+bool EspNowTransport::begin(uint8_t channel) {
+  if (started_) return true;
+  if (WiFi.getMode() == WIFI_OFF) {
+    WiFi.mode(WIFI_STA);
+  }
+  if (channel && !setChannel(channel)) {
+    return false;
+  }
+  if (esp_now_init() != ESP_OK) {
+    LOG_W("ESP-NOW init failed");
+    return false;
+  }
+  esp_now_register_recv_cb(onEspNowRecv);
+  s_active = this;
+  clearPeers();  // esp_now_deinit dropped them
+  started_ = ensurePeer(HIVELINK_BROADCAST);
+  return started_;
+}
+
+void EspNowTransport::end() {
+  if (!started_) return;
+  esp_now_unregister_recv_cb();
+  esp_now_deinit();
+  s_active = nullptr;
+  started_ = false;
+}
+
+bool EspNowTransport::setChannel(uint8_t channel) {
+  // Channel can only be forced while not associated; promiscuous toggle applies it
+  esp_wifi_set_promiscuous(true);
+  esp_err_t err = esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+  esp_wifi_set_promiscuous(false);
+  return err == ESP_OK;
+}
+
+bool EspNowTransport::addPeer(const uint8_t mac[6]) {
+  if (ensurePeer(mac)) return true;
+  LOG_W("ESP-NOW add peer failed");
+  return false;
+}
+
+void EspNowTransport::removePeer(const uint8_t mac[6]) {
+  esp_now_del_peer(mac);
+}
+
+bool EspNowTransport::send(const uint8_t dstMac[6], const uint8_t *data, size_t len) {
+  // The gateway acks every leaf by unicast: keep only the recent ones registered
+  if (!started_ || !usePeer(dstMac)) return false;
+  return esp_now_send(dstMac, data, len) == ESP_OK;
+}
@@ -0,0 +1,57 @@
+// ESP-NOW transport for HiveLink plus apiary role configuration
+#pragma once
+
+#include <Arduino.h>
+#include "hivelink.h"
+
+// Node roles: standalone joins Wi-Fi itself; leaves hand records to a gateway
+// over ESP-NOW and sleep; the gateway stays up and uplinks the whole apiary.
+#define HIVESYNC_ROLE_STANDALONE 0
+#define HIVESYNC_ROLE_LEAF       1
+#define HIVESYNC_ROLE_GATEWAY    2
+#ifndef HIVESYNC_ROLE
+#define HIVESYNC_ROLE HIVESYNC_ROLE_STANDALONE
+#endif
+
+// Channel leaves try first (the gateway follows its AP's channel; leaves
+// sweep 1-13 and remember the channel that acked)
+#ifndef HIVELINK_CHANNEL
+#define HIVELINK_CHANNEL 1
+#endif
+#ifndef HIVELINK_ACK_TIMEOUT_MS
+#define HIVELINK_ACK_TIMEOUT_MS 30
+#endif
+#ifndef HIVELINK_RETRIES
+#define HIVELINK_RETRIES 3
+#endif
+// Records the gateway buffers between uplinks
+#ifndef HIVELINK_GATEWAY_SLOTS
+#define HIVELINK_GATEWAY_SLOTS 64
+#endif
+
+// Only one instance may be active (ESP-NOW callbacks carry no context)
+class EspNowTransport : public HiveLinkTransport {
+ public:
+  // Brings Wi-Fi up in STA mode if needed. channel 0 keeps the current channel
+  // (gateway: the AP's); otherwise the radio is tuned to it (leaf).
+  bool begin(uint8_t channel);
+  void end();
+  bool setChannel(uint8_t channel);
+
+  bool send(const uint8_t dstMac[6], const uint8_t *data, size_t len) override;
+  uint32_t nowMs() override { return millis(); }
+  void waitMs(uint32_t ms) override { delay(ms); }
+  void lock() override { portENTER_CRITICAL(&mux_); }
+  void unlock() override { portEXIT_CRITICAL(&mux_); }
+
+  // Entry point for the ESP-NOW receive callback (Wi-Fi task context)
+  static void dispatch(const uint8_t *mac, const uint8_t *data, int len);
+
+ protected:
+  bool addPeer(const uint8_t mac[6]) override;
+  void removePeer(const uint8_t mac[6]) override;
+
+ private:
+  portMUX_TYPE mux_ = portMUX_INITIALIZER_UNLOCKED;
+  bool started_ = false;
+};
@@ -0,0 +1,118 @@
+// In-process HiveLink transport for host tests and load simulation.
+// Frames are delivered synchronously through a hub with a virtual clock and
+// optional deterministic loss; not used by the firmware build. Each endpoint
+// models the radio's peer table like ESP-NOW: unicast needs a registered peer,
+// and at most HIVELINK_RADIO_PEERS (broadcast included) can be registered.
+#pragma once
+
+#include <string.h>
+
+#include <array>
+#include <vector>
+
+#include "hivelink.h"
+
+class LoopbackTransport;
+
+class LoopbackHub {
+ public:
+  // lossPermille: probability (0-1000) that any single frame is lost
+  explicit LoopbackHub(uint16_t lossPermille = 0, uint32_t seed = 1) : loss_(lossPermille), rng_(seed) {}
+
+  uint32_t now() const { return nowMs_; }
+  void advance(uint32_t ms) { nowMs_ += ms; }
+  uint32_t framesSent() const { return sent_; }
+  uint32_t framesLost() const { return lost_; }
+
+  void attach(LoopbackTransport *t) { endpoints_.push_back(t); }
+  void detach(LoopbackTransport *t) {
+    for (size_t i = 0; i < endpoints_.size(); ++i) {
+      if (endpoints_[i] == t) {
+        endpoints_.erase(endpoints_.begin() + i);
+        return;
+      }
+    }
+  }
+
+  inline bool route(const uint8_t srcMac[6], const uint8_t dstMac[6], const uint8_t *data, size_t len);
+
+ private:
+  bool dropFrame() {
+    rng_ = rng_ * 1664525u + 1013904223u;
+    return loss_ && ((rng_ >> 8) % 1000u) < loss_;
+  }
+
+  std::vector<LoopbackTransport *> endpoints_;
+  uint16_t loss_;
+  uint32_t rng_;
+  uint32_t nowMs_ = 0;
+  uint32_t sent_ = 0;
+  uint32_t lost_ = 0;
+};
+
+class LoopbackTransport : public HiveLinkTransport {
+ public:
+  LoopbackTransport(LoopbackHub &hub, const uint8_t mac[6]) : hub_(hub) {
+    memcpy(mac_, mac, 6);
+    hub_.attach(this);
+    addPeer(HIVELINK_BROADCAST);
+  }
+  ~LoopbackTransport() override { hub_.detach(this); }
+
+  const uint8_t *mac() const { return mac_; }
+  size_t peers() const { return peers_.size(); }
+  size_t peakPeers() const { return peakPeers_; }
+
+  bool send(const uint8_t dstMac[6], const uint8_t *data, size_t len) override {
+    if (!usePeer(dstMac) || findPeer(dstMac) == peers_.size()) return false;
+    return hub_.route(mac_, dstMac, data, len);
+  }
+  uint32_t nowMs() override { return hub_.now(); }
+  void waitMs(uint32_t ms) override { hub_.advance(ms); }
+
+  void receive(const uint8_t srcMac[6], const uint8_t *data, size_t len) { deliver(srcMac, data, len); }
+
+ protected:
+  bool addPeer(const uint8_t mac[6]) override {
+    if (findPeer(mac) < peers_.size()) return true;
+    if (peers_.size() >= HIVELINK_RADIO_PEERS) return false;
+    std::array<uint8_t, 6> p;
+    memcpy(p.data(), mac, 6);
+    peers_.push_back(p);
+    if (peers_.size() > peakPeers_) peakPeers_ = peers_.size();
+    return true;
+  }
+  void removePeer(const uint8_t mac[6]) override {
+    const size_t i = findPeer(mac);
+    if (i < peers_.size()) peers_.erase(peers_.begin() + i);
+  }
+
+ private:
+  size_t findPeer(const uint8_t mac[6]) const {
+    for (size_t i = 0; i < peers_.size(); ++i) {
+      if (memcmp(peers_[i].data(), mac, 6) == 0) return i;
+    }
+    return peers_.size();
+  }
+
+  LoopbackHub &hub_;
+  uint8_t mac_[6];
+  std::vector<std::array<uint8_t, 6>> peers_;
+  size_t peakPeers_ = 0;
+};
+
+inline bool LoopbackHub::route(const uint8_t srcMac[6], const uint8_t dstMac[6], const uint8_t *data, size_t len) {
+  sent_++;
+  if (dropFrame()) {
+    lost_++;
+    return true;  // like a radio, the sender cannot tell
+  }
+  const bool broadcast = memcmp(dstMac, HIVELINK_BROADCAST, 6) == 0;
+  // Snapshot: receivers may send (acks) and re-enter route()
+  const std::vector<LoopbackTransport *> targets = endpoints_;
+  for (LoopbackTransport *t : targets) {
+    if (memcmp(t->mac(), srcMac, 6) == 0) continue;
+    if (broadcast || memcmp(t->mac(), dstMac, 6) == 0) t->receive(srcMac, data, len);
+  }
+  return true;
+}
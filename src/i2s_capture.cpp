@@ -0,0 +1,79 @@
+#include "i2s_capture.h"
+
+#include "audio_inmp441.h"
+
+#include "driver/i2s.h"
+#include "esp_heap_caps.h"
+
+static I2sCaptureStats s_stats;
+
+static int32_t *s_block = nullptr;
+
+bool i2s_capture_begin(uint32_t sampleRate) {
+  memset(&s_stats, 0, sizeof(s_stats));
+  s_block = (int32_t *)heap_caps_malloc(sizeof(int32_t) * I2S_DMA_FRAME_NUM, MALLOC_CAP_8BIT);
+  if (!s_block) return false;
+
+  // I2S configuration for standard I2S, 32-bit samples, RX only
+  i2s_config_t i2s_config = {};
+  i2s_config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX);
+  i2s_config.sample_rate = sampleRate;
+  i2s_config.bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT;
+  i2s_config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT; // INMP441 with L/R tied to GND -> left channel
+  i2s_config.communication_format = I2S_COMM_FORMAT_STAND_MSB;
+  i2s_config.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1;
+  i2s_config.dma_buf_count = I2S_DMA_DESC_NUM;
+  i2s_config.dma_buf_len = I2S_DMA_FRAME_NUM; // samples per DMA buffer
+  i2s_config.use_apll = false;
+  i2s_config.tx_desc_auto_clear = false;
+  i2s_config.fixed_mclk = 0;
+
+  i2s_pin_config_t pin_config = {};
+  pin_config.bck_io_num = I2S_SCK_PIN;
+  pin_config.ws_io_num = I2S_WS_PIN;
+  pin_config.data_out_num = I2S_PIN_NO_CHANGE; // microphone is input-only
+  pin_config.data_in_num = I2S_SD_PIN;
+
+  if (i2s_driver_install(I2S_NUM_0, &i2s_config, 0, nullptr) != ESP_OK) {
+    free(s_block);
+    s_block = nullptr;
+    return false;
+  }
+  if (i2s_set_pin(I2S_NUM_0, &pin_config) != ESP_OK) {
+    i2s_driver_uninstall(I2S_NUM_0);
+    free(s_block);
+    s_block = nullptr;
+    return false;
+  }
+  // Ensure clock is set (some IDF versions require explicit set after driver install)
+  i2s_set_clk(I2S_NUM_0, sampleRate, I2S_BITS_PER_SAMPLE_32BIT, I2S_CHANNEL_MONO);
+  return true;
+}
+
+// The driver copies each DMA buffer out into s_block
+const int32_t *i2s_capture_next(size_t &count) {
+  uint8_t *ptr = reinterpret_cast<uint8_t *>(s_block);
+  const size_t bytes = sizeof(int32_t) * I2S_DMA_FRAME_NUM;
+  size_t total = 0;
+  const uint32_t t0 = micros();
+  while (total < bytes) {
+    size_t br = 0;
+    i2s_read(I2S_NUM_0, ptr + total, bytes - total, &br, pdMS_TO_TICKS(I2S_READ_TIMEOUT_MS));
+    if (br == 0) break;
+    total += br;
+  }
+  s_stats.waitUs += micros() - t0;  // includes the driver's copy
+  if (total < bytes) return nullptr;
+  s_stats.blocks++;
+  count = I2S_DMA_FRAME_NUM;
+  return s_block;
+}
+
+void i2s_capture_end(I2sCaptureStats *out) {
+  i2s_driver_uninstall(I2S_NUM_0);
+  if (s_block) {
+    free(s_block);
+    s_block = nullptr;
+  }
+  if (out) *out = s_stats;
+}
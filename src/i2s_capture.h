@@ -0,0 +1,35 @@
+// INMP441 I2S capture: hands the analysis one DMA buffer's worth of samples
+// at a time, so an FFT frame is windowed as it arrives instead of being staged
+// whole first
+//
+// Uses the legacy I2S driver of Arduino core 2.x (ESP-IDF 4.4), whose
+// i2s_read() copies each buffer once into a block-sized staging area.
+//
+// The DMA ring is I2S_DMA_DESC_NUM buffers of I2S_DMA_FRAME_NUM samples; an
+// FFT frame (the analysis hop) must be a whole number of buffers.
+#pragma once
+
+#include <Arduino.h>
+
+#ifndef I2S_DMA_FRAME_NUM
+#define I2S_DMA_FRAME_NUM 512  // samples per DMA buffer (32 ms at 16 kHz)
+#endif
+#ifndef I2S_DMA_DESC_NUM
+#define I2S_DMA_DESC_NUM 16    // two 4096-sample frames in flight
+#endif
+static_assert(I2S_DMA_FRAME_NUM * 4 <= 4092, "DMA buffer exceeds one descriptor");
+
+struct I2sCaptureStats {
+  uint32_t blocks;  // blocks handed out
+  uint64_t waitUs;  // time spent in i2s_read(), including its copy
+};
+
+// Install the driver, 32-bit mono (left slot), RX only
+bool i2s_capture_begin(uint32_t sampleRate);
+
+// Next block of count raw 32-bit words, valid until the following call.
+// nullptr if no data arrives within I2S_READ_TIMEOUT_MS (clock or DMA stalled).
+const int32_t *i2s_capture_next(size_t &count);
+
+// Uninstall the driver; optionally report the capture's counters
+void i2s_capture_end(I2sCaptureStats *out = nullptr);
@@ -0,0 +1,137 @@
+#include "log.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Drain runs on the core not used by loop()/capture, at the lowest useful priority
+#define LOG_DRAIN_CORE   0
+#define LOG_DRAIN_PRIO   1
+#define LOG_DRAIN_STACK  4096
+#define LOG_DRAIN_IDLE_MS 5
+#define LOG_LINE_MAX     192
+
+LogRing g_logRing;
+
+static TaskHandle_t s_drainTask = nullptr;
+static volatile bool s_writing = false;
+static uint32_t s_droppedReported = 0;
+
+// Bulk lines (log_writeLine) as text, newline included. Producers append
+// under s_lineMux; the drain writes [head, tail) outside it and then advances
+// head, so appends never touch bytes still being written.
+static char s_lines[LOG_LINE_BUF_BYTES];
+static size_t s_lineHead = 0, s_lineTail = 0;  // free-running byte counts
+static uint32_t s_linesDropped = 0;
+static portMUX_TYPE s_lineMux = portMUX_INITIALIZER_UNLOCKED;
+
+static size_t linesPending() {
+  portENTER_CRITICAL(&s_lineMux);
+  const size_t n = s_lineTail - s_lineHead;
+  portEXIT_CRITICAL(&s_lineMux);
+  return n;
+}
+
+// Write out the queued bulk lines; false if there were none
+static bool drainLines() {
+  bool any = false;
+  for (;;) {
+    portENTER_CRITICAL(&s_lineMux);
+    const size_t head = s_lineHead, tail = s_lineTail;
+    portEXIT_CRITICAL(&s_lineMux);
+    if (head == tail) return any;
+    // Contiguous run up to the end of the buffer
+    const size_t at = head % LOG_LINE_BUF_BYTES;
+    size_t n = tail - head;
+    if (n > LOG_LINE_BUF_BYTES - at) n = LOG_LINE_BUF_BYTES - at;
+    Serial.write((const uint8_t *)s_lines + at, n);
+    portENTER_CRITICAL(&s_lineMux);
+    s_lineHead += n;
+    portEXIT_CRITICAL(&s_lineMux);
+    any = true;
+  }
+}
+
+// Format and write everything currently queued; false if nothing was pending
+static bool drainOnce() {
+  static char line[LOG_LINE_MAX + 2];
+  LogEntry e;
+  bool any = false;
+  // Set before popping so log_flush() never sees an entry that is neither
+  // queued nor written yet
+  s_writing = true;
+  while (g_logRing.pop(e)) {
+    any = true;
+    size_t n = log_formatEntry(e, line, LOG_LINE_MAX);
+    line[n++] = '\n';
+    Serial.write((const uint8_t *)line, n);
+  }
+  if (drainLines()) any = true;
+  const uint32_t dropped = log_dropped();
+  if (dropped != s_droppedReported) {
+    Serial.printf("log: %lu messages dropped\n", (unsigned long)(dropped - s_droppedReported));
+    s_droppedReported = dropped;
+  }
+  s_writing = false;
+  return any;
+}
+
+static void drainTask(void *) {
+  for (;;) {
+    if (!drainOnce()) vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_IDLE_MS));
+  }
+}
+
+void log_checkFormat(const char *, ...) {}
+
+void log_begin() {
+  if (s_drainTask) return;
+  xTaskCreatePinnedToCore(drainTask, "log", LOG_DRAIN_STACK, nullptr, LOG_DRAIN_PRIO, &s_drainTask,
+                          LOG_DRAIN_CORE);
+}
+
+bool log_flush(uint32_t timeoutMs) {
+  if (!s_drainTask) {
+    drainOnce();
+    return true;
+  }
+  const uint32_t start = millis();
+  while (!g_logRing.empty() || linesPending() || s_writing) {
+    if (millis() - start >= timeoutMs) return false;
+    delay(1);
+  }
+  return true;
+}
+
+void log_writeLine(const char *line) {
+  const size_t len = strlen(line) + 1;
+  if (len > LOG_LINE_BUF_BYTES) {
+    s_linesDropped++;
+    return;
+  }
+  // Normally just a copy; only a burst larger than the buffer waits for the
+  // drain, and then no longer than a sleep flush
+  const uint32_t start = millis();
+  for (;;) {
+    portENTER_CRITICAL(&s_lineMux);
+    const size_t tail = s_lineTail;
+    const bool room = LOG_LINE_BUF_BYTES - (tail - s_lineHead) >= len;
+    if (room) {
+      for (size_t i = 0; i < len; ++i) s_lines[(tail + i) % LOG_LINE_BUF_BYTES] = i + 1 < len ? line[i] : '\n';
+      s_lineTail = tail + len;
+    }
+    portEXIT_CRITICAL(&s_lineMux);
+    if (room) return;
+    if (!s_drainTask) {
+      drainOnce();
+    } else if (millis() - start >= LOG_SLEEP_FLUSH_MS) {
+      s_linesDropped++;
+      return;
+    } else {
+      delay(1);
+    }
+  }
+}
+
+uint32_t log_dropped() {
+  return g_logRing.dropped() + s_linesDropped;
+}
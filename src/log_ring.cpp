@@ -0,0 +1,203 @@
+#include "log_ring.h"
+
+#include <stdio.h>
+
+void LogArgWriter::putStr(const char *s) {
+  if (!s) s = "(null)";
+  const size_t room = LOG_ARG_BYTES - e_.used;
+  if (full_ || e_.nargs >= LOG_MAX_ARGS || room < 2) {
+    full_ = true;
+    return;
+  }
+  size_t n = strnlen(s, LOG_MAX_STR - 1);
+  if (n + 2 > room) n = room - 2;  // truncate to what is left rather than drop it
+  e_.tags[e_.nargs++] = LOG_ARG_STR;
+  e_.data[e_.used++] = (uint8_t)(n + 1);
+  memcpy(e_.data + e_.used, s, n);
+  e_.data[e_.used + n] = '\0';
+  e_.used += (uint8_t)(n + 1);
+}
+
+// ---------------- Ring ----------------
+
+LogRing::LogRing() {
+  for (uint32_t i = 0; i < LOG_RING_SLOTS; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+}
+
+LogRing::Cell *LogRing::claim() {
+  uint32_t pos = enqueuePos_.load(std::memory_order_relaxed);
+  for (;;) {
+    Cell *c = &cells_[pos & (LOG_RING_SLOTS - 1)];
+    const int32_t dif = (int32_t)(c->seq.load(std::memory_order_acquire) - pos);
+    if (dif == 0) {
+      if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        c->pos = pos;
+        return c;
+      }
+    } else if (dif < 0) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    } else {
+      pos = enqueuePos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool LogRing::pop(LogEntry &out) {
+  const uint32_t pos = dequeuePos_.load(std::memory_order_relaxed);
+  Cell *c = &cells_[pos & (LOG_RING_SLOTS - 1)];
+  if (c->seq.load(std::memory_order_acquire) != pos + 1) return false;
+  out.fmt = c->e.fmt;
+  out.level = c->e.level;
+  out.nargs = c->e.nargs;
+  out.used = c->e.used;
+  memcpy(out.tags, c->e.tags, out.nargs);
+  memcpy(out.data, c->e.data, out.used);
+  c->seq.store(pos + LOG_RING_SLOTS, std::memory_order_release);
+  dequeuePos_.store(pos + 1, std::memory_order_relaxed);
+  return true;
+}
+
+bool LogRing::empty() const {
+  const uint32_t pos = dequeuePos_.load(std::memory_order_relaxed);
+  const Cell &c = cells_[pos & (LOG_RING_SLOTS - 1)];
+  return c.seq.load(std::memory_order_acquire) != pos + 1;
+}
+
+// ---------------- Formatting ----------------
+
+namespace {
+
+struct ArgReader {
+  const LogEntry &e;
+  uint8_t index = 0;
+  uint8_t offset = 0;
+
+  bool next(uint8_t &tag, const uint8_t *&p) {
+    if (index >= e.nargs) return false;
+    tag = e.tags[index++];
+    p = e.data + offset;
+    switch (tag) {
+      case LOG_ARG_I32: case LOG_ARG_U32: case LOG_ARG_F32: offset += 4; break;
+      case LOG_ARG_STR: p += 1; offset += 1 + e.data[offset]; break;
+      default: offset += 8; break;
+    }
+    return true;
+  }
+};
+
+template <typename T>
+T load(const uint8_t *p) {
+  T v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// Argument as an integer for %d/%u/%x/%c...; 32-bit values keep C's
+// reinterpretation (e.g. %d of a uint32_t prints it signed)
+long long asInteger(uint8_t tag, const uint8_t *p, bool isSigned) {
+  switch (tag) {
+    case LOG_ARG_I32: case LOG_ARG_U32: {
+      const uint32_t u = load<uint32_t>(p);
+      return isSigned ? (long long)(int32_t)u : (long long)u;
+    }
+    case LOG_ARG_F32: return (long long)load<float>(p);
+    case LOG_ARG_F64: return (long long)load<double>(p);
+    case LOG_ARG_STR: return 0;
+    default: return (long long)load<uint64_t>(p);
+  }
+}
+
+double asDouble(uint8_t tag, const uint8_t *p) {
+  switch (tag) {
+    case LOG_ARG_F32: return load<float>(p);
+    case LOG_ARG_F64: return load<double>(p);
+    case LOG_ARG_I32: return (int32_t)load<uint32_t>(p);
+    case LOG_ARG_U32: return load<uint32_t>(p);
+    case LOG_ARG_I64: return (double)(int64_t)load<uint64_t>(p);
+    case LOG_ARG_STR: return 0.0;
+    default: return (double)load<uint64_t>(p);
+  }
+}
+
+}  // namespace
+
+size_t log_formatEntry(const LogEntry &e, char *out, size_t cap) {
+  if (!cap) return 0;
+  size_t n = 0;
+  ArgReader args{e};
+  const char *f = e.fmt ? e.fmt : "";
+  auto room = [&]() { return n < cap ? cap - n : 0; };
+  auto advance = [&](int w) {
+    if (w > 0) n += (size_t)w;
+    if (n >= cap) n = cap - 1;
+  };
+
+  while (*f && n + 1 < cap) {
+    if (*f != '%') {
+      out[n++] = *f++;
+      continue;
+    }
+    if (f[1] == '%') {
+      out[n++] = '%';
+      f += 2;
+      continue;
+    }
+    // Rebuild the conversion with a normalized length modifier
+    char spec[24];
+    size_t s = 0;
+    spec[s++] = *f++;
+    while (*f && strchr("-+ #0", *f) && s < 10) spec[s++] = *f++;
+    while (*f >= '0' && *f <= '9' && s < 14) spec[s++] = *f++;
+    if (*f == '.') {
+      spec[s++] = *f++;
+      while (*f >= '0' && *f <= '9' && s < 18) spec[s++] = *f++;
+    }
+    while (*f && strchr("hlLqjzt", *f)) f++;
+    const char conv = *f;
+    if (!conv) break;
+    f++;
+
+    uint8_t tag;
+    const uint8_t *p;
+    if (!args.next(tag, p)) {
+      out[n++] = '?';
+      continue;
+    }
+    switch (conv) {
+      case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': {
+        spec[s++] = 'l';
+        spec[s++] = 'l';
+        spec[s++] = conv;
+        spec[s] = '\0';
+        const bool sgn = (conv == 'd' || conv == 'i');
+        const long long v = asInteger(tag, p, sgn);
+        advance(sgn ? snprintf(out + n, room(), spec, v) : snprintf(out + n, room(), spec, (unsigned long long)v));
+        break;
+      }
+      case 'c':
+        spec[s++] = conv;
+        spec[s] = '\0';
+        advance(snprintf(out + n, room(), spec, (int)asInteger(tag, p, true)));
+        break;
+      case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        spec[s++] = conv;
+        spec[s] = '\0';
+        advance(snprintf(out + n, room(), spec, asDouble(tag, p)));
+        break;
+      case 's':
+        spec[s++] = 's';
+        spec[s] = '\0';
+        advance(snprintf(out + n, room(), spec, tag == LOG_ARG_STR ? (const char *)p : "?"));
+        break;
+      case 'p':
+        advance(snprintf(out + n, room(), "%p", (void *)(uintptr_t)asInteger(tag, p, false)));
+        break;
+      default:
+        out[n++] = '?';
+        break;
+    }
+  }
+  out[n] = '\0';
+  return n;
+}
@@ -0,0 +1,140 @@
+// Lock-free multi-producer log ring with deferred printf formatting
+// Portable (no Arduino dependencies) so it can be exercised on the host.
+//
+// Producers store the format pointer (a string literal) and their arguments
+// as typed binary slots; strings are copied, truncated to LOG_MAX_STR. A
+// single consumer pops entries and does the formatting. The ring is Vyukov's
+// bounded queue: one CAS to claim a cell, a release store to publish it. When
+// full, the entry is dropped and counted rather than blocking the producer.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <type_traits>
+
+#ifndef LOG_RING_SLOTS
+#define LOG_RING_SLOTS 64  // power of two
+#endif
+#ifndef LOG_ARG_BYTES
+#define LOG_ARG_BYTES 48   // argument bytes per entry (strings included)
+#endif
+#define LOG_MAX_ARGS 8
+#ifndef LOG_MAX_STR
+#define LOG_MAX_STR 32     // longest copied string argument (incl. NUL)
+#endif
+
+enum LogArgTag : uint8_t {
+  LOG_ARG_I32,
+  LOG_ARG_U32,
+  LOG_ARG_I64,
+  LOG_ARG_U64,
+  LOG_ARG_F32,
+  LOG_ARG_F64,
+  LOG_ARG_STR,  // length byte, then bytes including NUL
+  LOG_ARG_PTR,
+};
+
+struct LogEntry {
+  const char *fmt;
+  uint8_t level;
+  uint8_t nargs;
+  uint8_t used;  // bytes of data in use
+  uint8_t tags[LOG_MAX_ARGS];
+  uint8_t data[LOG_ARG_BYTES];
+};
+
+// Serializes arguments into an entry; anything that does not fit is left off
+// and prints as '?'
+class LogArgWriter {
+ public:
+  explicit LogArgWriter(LogEntry &e) : e_(e) {}
+
+  template <typename T>
+  void put(const T &v) {
+    using D = std::decay_t<T>;
+    if constexpr (std::is_same_v<D, const char *> || std::is_same_v<D, char *>) {
+      putStr(v);
+    } else if constexpr (std::is_same_v<D, float>) {
+      putRaw(LOG_ARG_F32, &v, sizeof(float));
+    } else if constexpr (std::is_floating_point_v<D>) {
+      const double d = (double)v;
+      putRaw(LOG_ARG_F64, &d, sizeof(d));
+    } else if constexpr (std::is_enum_v<D>) {
+      put(static_cast<std::underlying_type_t<D>>(v));
+    } else if constexpr (std::is_integral_v<D> && sizeof(D) <= 4) {
+      const uint32_t u = (uint32_t)v;
+      putRaw(std::is_signed_v<D> ? LOG_ARG_I32 : LOG_ARG_U32, &u, sizeof(u));
+    } else if constexpr (std::is_integral_v<D>) {
+      const uint64_t u = (uint64_t)v;
+      putRaw(std::is_signed_v<D> ? LOG_ARG_I64 : LOG_ARG_U64, &u, sizeof(u));
+    } else if constexpr (std::is_pointer_v<D>) {
+      const uint64_t u = (uint64_t)(uintptr_t)v;
+      putRaw(LOG_ARG_PTR, &u, sizeof(u));
+    } else {
+      static_assert(std::is_pointer_v<D>, "unsupported log argument type (use c_str() for String)");
+    }
+  }
+
+ private:
+  void putRaw(LogArgTag tag, const void *p, size_t n) {
+    if (full_ || e_.nargs >= LOG_MAX_ARGS || e_.used + n > LOG_ARG_BYTES) {
+      full_ = true;
+      return;
+    }
+    e_.tags[e_.nargs++] = tag;
+    memcpy(e_.data + e_.used, p, n);
+    e_.used += (uint8_t)n;
+  }
+  void putStr(const char *s);
+
+  LogEntry &e_;
+  bool full_ = false;
+};
+
+// Format an entry as printf would (without a trailing newline); returns length
+size_t log_formatEntry(const LogEntry &e, char *out, size_t cap);
+
+class LogRing {
+ public:
+  static_assert((LOG_RING_SLOTS & (LOG_RING_SLOTS - 1)) == 0, "LOG_RING_SLOTS must be a power of two");
+
+  LogRing();
+
+  // Any thread/task. Never blocks; returns false (and counts a drop) when full.
+  template <typename... Args>
+  bool push(uint8_t level, const char *fmt, const Args &...args) {
+    Cell *c = claim();
+    if (!c) return false;
+    c->e.fmt = fmt;
+    c->e.level = level;
+    c->e.nargs = 0;
+    c->e.used = 0;
+    LogArgWriter w(c->e);
+    (w.put(args), ...);
+    publish(c);
+    return true;
+  }
+
+  // Single consumer: copy out the oldest entry, false when empty
+  bool pop(LogEntry &out);
+  bool empty() const;
+  uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Cell {
+    std::atomic<uint32_t> seq;
+    uint32_t pos;
+    LogEntry e;
+  };
+
+  Cell *claim();
+  void publish(Cell *c) { c->seq.store(c->pos + 1, std::memory_order_release); }
+
+  Cell cells_[LOG_RING_SLOTS];
+  std::atomic<uint32_t> enqueuePos_{0};
+  std::atomic<uint32_t> dequeuePos_{0};  // written by the consumer only
+  std::atomic<uint32_t> dropped_{0};
+};
@@ -2,8 +2,11 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <WiFiProv.h>
+#include "wifi_provisioning/manager.h"
 #include "esp_sleep.h"
+#include "driver/rtc_io.h"
 
+#include "log.h"
 #include "display.h"
 #include "buttons.h"
 #include "sensors.h"
@@ -11,6 +14,17 @@
 #include "battery.h"
 // INMP441 I2S microphone + FFT
 #include "audio_inmp441.h"
+// IMA-ADPCM clip recording to flash
+#include "audio_clip.h"
+// Compact record + ESP-NOW apiary aggregation
+#include "record.h"
+#include "hivelink_espnow.h"
+// Wall-clock time across deep sleep
+#include "timekeeping.h"
+// Per-sensor cadences across deep sleep
+#include "scheduler.h"
+// Stage deadlines, wake budget and task watchdog
+#include "supervisor.h"
 
 // Globals for device identity
 String g_deviceName;  // HiveSync-<last4>
@@ -19,11 +33,143 @@ String g_pop;         // Hive-<last6>
 // Run-once flags
 static bool g_pendingSampleAfterIP = false;
 static bool g_sampleDone = false;
+static bool g_recordClip = false;
+
+#if HIVESYNC_ROLE == HIVESYNC_ROLE_STANDALONE
+// Temperature/weight are read in setup(), before the wait for an IP; the
+// record is finished in loop()
+static HiveRecord g_rec;
+static bool g_wifiOn = false;  // provisioning/Wi-Fi started this wake
+static float g_tempC = NAN;
+static bool g_tempOK = false;
+static bool g_hxUsable = false;
+static uint32_t g_sampleMs = 0;
+static char g_weightLine[40];
+#endif
+
+// Timer wakes run headless: no TFT, backlight or button UI, peripherals on first use
+static bool g_headless = false;
+static esp_sleep_wakeup_cause_t g_wakeCause = ESP_SLEEP_WAKEUP_UNDEFINED;
 
 // Boot button hold thresholds (ms)
 #define CLEAR_PROV_HOLD_MS 2500
 #define CALIBRATE_HOLD_MS  6000
 
+// Optional spectrogram capture (dumped as hex over serial; decode with tools/spectro_decode.cpp)
+#ifndef AUDIO_SPECTROGRAM
+#define AUDIO_SPECTROGRAM 0
+#endif
+#ifndef SPECTRO_BUF_BYTES
+#define SPECTRO_BUF_BYTES 4096
+#endif
+
+// Load-cell activity during the audio capture (HX711 streamed on core 0).
+// Its effect on the capture is not measured yet: build with
+// -DWEIGHT_ACTIVITY_STREAM=0 to leave the HX711 idle during the capture and
+// compare the "Frame timing" log lines of the two builds.
+#ifndef WEIGHT_ACTIVITY
+#define WEIGHT_ACTIVITY 0
+#endif
+#ifndef WEIGHT_ACTIVITY_STREAM
+#define WEIGHT_ACTIVITY_STREAM 1
+#endif
+
+// Audio evidence clip: hold D2 at boot to record this wake, or build with -DAUDIO_CLIP_ALWAYS=1
+#ifndef AUDIO_CLIP_SECONDS
+#define AUDIO_CLIP_SECONDS 10
+#endif
+#ifndef AUDIO_CLIP_ALWAYS
+#define AUDIO_CLIP_ALWAYS 0
+#endif
+#define AUDIO_CLIP_PATH "/clip.wav"
+
+// Sensor cadences (seconds). Tasks due within SCHED_TOLERANCE_S of a wake run
+// in it; leaves/standalone sleep until the next deadline, the gateway uplinks
+// whenever a task ran.
+#ifndef WEIGHT_PERIOD_S
+#define WEIGHT_PERIOD_S (5UL * 60UL)   // nectar flow
+#endif
+#ifndef TEMP_PERIOD_S
+#define TEMP_PERIOD_S (15UL * 60UL)
+#endif
+#ifndef AUDIO_PERIOD_S
+#define AUDIO_PERIOD_S (60UL * 60UL)   // 60 s capture
+#endif
+#ifndef SCHED_TOLERANCE_S
+#define SCHED_TOLERANCE_S 30
+#endif
+
+enum SensorTask { TASK_WEIGHT, TASK_TEMP, TASK_AUDIO, TASK_COUNT };
+#define TASK_BIT(t) (1UL << (t))
+static const uint32_t kTaskPeriodsS[TASK_COUNT] = {WEIGHT_PERIOD_S, TEMP_PERIOD_S, AUDIO_PERIOD_S};
+// State kept in RTC memory is RTC_NOINIT so it also survives watchdog resets
+// (RTC_DATA_ATTR is reloaded on every reset but deep sleep); each struct
+// carries a magic that rejects power-on garbage.
+RTC_NOINIT_ATTR static SchedState g_sched;
+static uint32_t g_tasks = 0;  // tasks run this wake/cycle
+
+#if HIVESYNC_ROLE != HIVESYNC_ROLE_LEAF
+// Hourly/daily aggregates of this device's own records (leaves have no clock;
+// the gateway does not keep per-leaf rollups)
+RTC_NOINIT_ATTR static RollupState g_rollup;
+#endif
+
+#if HIVESYNC_ROLE == HIVESYNC_ROLE_LEAF
+// Survive deep sleep and resets: sequence for gateway dedup, cached gateway and channel
+#define LEAF_LINK_MAGIC 0x4C454146UL  // "LEAF"
+struct LeafLinkState {
+  uint32_t magic;
+  uint16_t seq;
+  uint8_t channel;
+  bool gatewayKnown;
+  uint8_t gateway[6];
+};
+RTC_NOINIT_ATTR static LeafLinkState g_leaf;
+#elif HIVESYNC_ROLE == HIVESYNC_ROLE_GATEWAY
+static_assert(sizeof(HiveRecord) <= HIVELINK_SLOT_PAYLOAD, "HiveRecord must fit a gateway slot");
+static EspNowTransport g_radio;
+static HiveLinkSlot g_gwSlots[HIVELINK_GATEWAY_SLOTS];
+static HiveLinkGateway g_gateway(g_radio, g_gwSlots, HIVELINK_GATEWAY_SLOTS);
+static bool g_radioUp = false;
+static bool g_wifiGaveUp = false;
+static uint32_t g_nextDueS = 0;  // RTC seconds of the earliest task deadline
+#endif
+
+#if WEIGHT_ACTIVITY
+static ActivityState g_activity;
+
+static void logActivity() {
+  ActivityResult r;
+  activity_finish(g_activity, r);
+  LOG_I("Activity: %lu samples at %.1f SPS (%lu gaps), sd %.1f counts", (unsigned long)r.samples, r.rateSps,
+        (unsigned long)r.gaps, r.sd);
+  LOG_I("Activity: %u departures, %u returns (step > %.0f counts)", r.departures, r.returns, r.stepThreshold);
+  LOG_I("Activity amplitude 0.5/1/2/3 Hz: %.1f/%.1f/%.1f/%.1f", r.amp[0], r.amp[1], r.amp[2], r.amp[3]);
+  LOG_I("Activity amplitude 5/8/12/20 Hz: %.1f/%.1f/%.1f/%.1f", r.amp[4], r.amp[5], r.amp[6], r.amp[7]);
+}
+#endif
+
+#if AUDIO_SPECTROGRAM
+static uint8_t g_spectroBuf[SPECTRO_BUF_BYTES];
+
+static void dumpSpectrogram(const AudioSpectrogram &sg) {
+  // Every line carries the prefix and its byte offset: log lines from other
+  // tasks can land inside the dump, and the decoder skips them and checks
+  // that no data line went missing
+  char line[96];
+  snprintf(line, sizeof(line), "SPECTRO BEGIN %u bytes, %u columns%s", (unsigned)sg.size, (unsigned)sg.columns,
+           sg.truncated ? " (truncated)" : "");
+  log_writeLine(line);
+  for (size_t i = 0; i < sg.size; i += 32) {
+    size_t n = sg.size - i < 32 ? sg.size - i : 32;
+    int at = snprintf(line, sizeof(line), "SPECTRO %u ", (unsigned)i);
+    for (size_t j = 0; j < n; ++j) at += snprintf(line + at, sizeof(line) - at, "%02x", sg.buf[i + j]);
+    log_writeLine(line);
+  }
+  log_writeLine("SPECTRO END");
+}
+#endif
+
 static String buildQRPayload(const String &name, const String &pop, const char *transport) {
   // Mirrors WiFiProv.printQR() payload
   String payload = "{";
@@ -51,18 +197,17 @@ void SysProvEvent(arduino_event_t *sys_event) {
   switch (sys_event->event_id) {
     case ARDUINO_EVENT_WIFI_STA_GOT_IP: {
       IPAddress ip(sys_event->event_info.got_ip.ip_info.ip.addr);
-      Serial.print("Connected IP address: ");
-      Serial.println(ip);
+      LOG_I("Connected IP address: %s", ip.toString().c_str());
       display_showIP(ip);
       // Mark ready to read sensors now that WiFi is connected
       g_pendingSampleAfterIP = true;
       break;
     }
     case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
-      Serial.println("WiFi disconnected. Reconnecting...");
+      LOG_I("WiFi disconnected. Reconnecting...");
       break;
     case ARDUINO_EVENT_PROV_START: {
-      Serial.println("Provisioning started. Use the app to provision.");
+      LOG_I("Provisioning started. Use the app to provision.");
       // Show QR code on TFT
       String payload = buildQRPayload(g_deviceName, g_pop, "ble");
       display_showQR(payload);
@@ -71,28 +216,67 @@ void SysProvEvent(arduino_event_t *sys_event) {
       break;
     }
     case ARDUINO_EVENT_PROV_CRED_RECV:
-      Serial.printf("Received Wi-Fi credentials\n\tSSID: %s\n\tPassword: %s\n",
-                    (const char *)sys_event->event_info.prov_cred_recv.ssid,
-                    (const char *)sys_event->event_info.prov_cred_recv.password);
+      // Never log the password
+      LOG_I("Received Wi-Fi credentials for SSID: %s", (const char *)sys_event->event_info.prov_cred_recv.ssid);
       break;
     case ARDUINO_EVENT_PROV_CRED_SUCCESS:
-      Serial.println("Provisioning successful");
+      LOG_I("Provisioning successful");
       break;
     case ARDUINO_EVENT_PROV_CRED_FAIL:
-      Serial.println("Provisioning failed. Reset to factory and retry.");
+      LOG_W("Provisioning failed. Reset to factory and retry.");
       if (sys_event->event_info.prov_fail_reason == WIFI_PROV_STA_AUTH_ERROR)
-        Serial.println("Reason: Wi-Fi AP password incorrect");
+        LOG_W("Reason: Wi-Fi AP password incorrect");
       else
-        Serial.println("Reason: AP not found or other error");
+        LOG_W("Reason: AP not found or other error");
       break;
     case ARDUINO_EVENT_PROV_END:
-      Serial.println("Provisioning ended");
+      LOG_I("Provisioning ended");
       break;
     default:
       break;
   }
 }
 
+// Register provisioning/WiFi events and start BLE provisioning, which joins
+// the stored network right away when already provisioned
+static void startProvisioning(bool resetProv) {
+  WiFi.onEvent(SysProvEvent);
+
+  // Credentials persist via NVS by default.
+  // Using BLE scheme with security 1 (PoP) and our custom service name / PoP.
+  uint8_t uuid[16] = {0xb4, 0xdf, 0x5a, 0x1c, 0x3f, 0x6b, 0xf4, 0xbf,
+                      0xea, 0x4a, 0x82, 0x03, 0x04, 0x90, 0x1a, 0x02};
+  WiFiProv.beginProvision(
+      WIFI_PROV_SCHEME_BLE,
+      WIFI_PROV_SCHEME_HANDLER_FREE_BTDM,
+      WIFI_PROV_SECURITY_1,
+      g_pop.c_str(),
+      g_deviceName.c_str(),
+      nullptr,
+      uuid,
+      resetProv  // clear provisioning when D0 held during boot
+  );
+  supervisor_radio(true);
+}
+
+#if HIVESYNC_ROLE == HIVESYNC_ROLE_STANDALONE
+// Stop BLE provisioning (if still waiting for the app), the reconnect loop and
+// the Wi-Fi/BT radios. Nothing needs them once SNTP is done or the Wi-Fi stage
+// was given up, and the audio capture must not run with them on.
+static void stopWiFi() {
+  if (!g_wifiOn) return;
+  g_wifiOn = false;
+  WiFi.removeEvent(SysProvEvent);
+  wifi_prov_mgr_deinit();
+  WiFi.setAutoReconnect(false);
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+  btStop();
+  supervisor_radio(false);
+  LOG_I("Wi-Fi and BLE off after %lu ms", (unsigned long)millis());
+}
+#endif
+
 // Return true if D0 is held for hold_ms at boot
 static bool bootLongPressToClear(uint32_t hold_ms = CLEAR_PROV_HOLD_MS) {
   return buttons_measureHoldMs(BOOT_BTN_PIN, hold_ms + 100, BOOT_BTN_INPUT_MODE, BOOT_BTN_ACTIVE_LEVEL) >= hold_ms;
@@ -100,11 +284,85 @@ static bool bootLongPressToClear(uint32_t hold_ms = CLEAR_PROV_HOLD_MS) {
 
 // Removed sensor helpers and calibration UI (moved to sensors module)
 
+// Tasks measured in a stage; stages outside measurement stand for every task
+static uint32_t stageTasks(WakeStage stage) {
+  switch (stage) {
+    case WAKE_TEMP: return TASK_BIT(TASK_TEMP);
+    case WAKE_WEIGHT: return TASK_BIT(TASK_WEIGHT);
+    case WAKE_AUDIO: return TASK_BIT(TASK_AUDIO);
+    default: return SCHED_ALL(TASK_COUNT);
+  }
+}
+
+// This wake's tasks: whatever is due, or everything (power-on/button wakes).
+// They are marked run only once measured (completeTasks), so a task that
+// hung the wake is retried after the watchdog reset.
+static uint32_t scheduleTasks(bool all) {
+  const uint32_t now = timekeeping_rtcSeconds();
+  sched_begin(g_sched, kTaskPeriodsS, TASK_COUNT, now);
+  uint32_t tasks = all ? SCHED_ALL(TASK_COUNT) : sched_dueMask(g_sched, now, SCHED_TOLERANCE_S);
+  // The retry hung too: leave that work for its next period rather than
+  // resetting every wake
+  const WakeStage hung = supervisor_repeatedHang();
+  const uint32_t skip = hung < WAKE_STAGES ? tasks & stageTasks(hung) : 0;
+  if (skip) {
+    sched_markRun(g_sched, skip, now);
+    tasks &= ~skip;
+    LOG_W("Skipping tasks 0x%lx this period: they hung the last two wakes", (unsigned long)skip);
+  }
+  if (tasks) {
+    LOG_I("Tasks:%s%s%s", (tasks & TASK_BIT(TASK_WEIGHT)) ? " weight" : "",
+          (tasks & TASK_BIT(TASK_TEMP)) ? " temp" : "", (tasks & TASK_BIT(TASK_AUDIO)) ? " audio" : "");
+  }
+  return tasks;
+}
+
+static void completeTasks(uint32_t tasks) {
+  sched_markRun(g_sched, tasks, timekeeping_rtcSeconds());
+}
+
+static void enterDeepSleep();
+static bool measureSensors(HiveRecord &rec, uint32_t tasks, float &tempC, char *weightLine, size_t weightLen,
+                           bool &hxUsable);
+
+static const char *wakeCauseName(esp_sleep_wakeup_cause_t cause) {
+  switch (cause) {
+    case ESP_SLEEP_WAKEUP_TIMER: return "timer";
+    case ESP_SLEEP_WAKEUP_EXT0: return "button";
+    case ESP_SLEEP_WAKEUP_EXT1: return "button";
+    case ESP_SLEEP_WAKEUP_UNDEFINED: return "power-on";
+    default: return "other";
+  }
+}
+
 void setup() {
+  // Scheduled wakes skip the whole UI path; power-on and button wakes get the full one.
+  // A wake ended by the watchdog comes back as a reset: resume headless on
+  // schedule (RTC_NOINIT state is kept) and retry the tasks it did not finish.
+  const bool watchdogReset = supervisor_init();
+  g_wakeCause = esp_sleep_get_wakeup_cause();
+  g_headless = (g_wakeCause == ESP_SLEEP_WAKEUP_TIMER) || watchdogReset;
+  display_setEnabled(!g_headless);
+
   Serial.begin(115200);
-  delay(100);
-  Serial.println();
-  Serial.println("HiveSync starting...");
+  log_begin();
+  if (!g_headless) delay(100);
+  log_writeLine("");
+  LOG_I("HiveSync starting (%s wake%s)...", wakeCauseName(g_wakeCause),
+        g_headless ? ", headless" : "");
+
+  // Restore wall-clock time from RTC memory (corrected for the measured sleep)
+  timekeeping_init();
+  if (timekeeping_valid()) {
+    LOG_I("Time: %lu (+/- %lu ms)", (unsigned long)timekeeping_nowUnix(),
+          (unsigned long)timekeeping_errorMs());
+  }
+
+  g_tasks = scheduleTasks(!g_headless);
+#if HIVESYNC_ROLE != HIVESYNC_ROLE_GATEWAY
+  // Timer fired early beyond the tolerance: nothing to do yet
+  if (g_headless && !g_tasks) enterDeepSleep();
+#endif
 
   // Compute identity strings from MAC
   String mac4 = cleanMacLastN(4);
@@ -112,125 +370,419 @@ void setup() {
   g_deviceName = String("HiveSync-") + mac4; // Device service name
   g_pop = String("Hive-") + mac6;           // Proof-of-possession
 
-  // Bring up display
-  display_init();
-  display_printAt("HiveSync", TFT_LINE_1, ST77XX_YELLOW);
-  display_printAt("Waiting...", TFT_LINE_2, ST77XX_WHITE);
-  // Init battery monitor and draw overlay early
-  battery_init();
-  display_drawBatteryTopRight();
+  // Sensors, battery gauge and audio initialize lazily on first use
+  g_recordClip = AUDIO_CLIP_ALWAYS;
+  bool resetProv = false;
+  if (!g_headless) {
+    // Bring up display
+    display_init();
+    display_printAt("HiveSync", TFT_LINE_1, ST77XX_YELLOW);
+    display_printAt("Waiting...", TFT_LINE_2, ST77XX_WHITE);
+    // Init battery monitor and draw overlay early
+    battery_init();
+    display_drawBatteryTopRight();
 
-  // Init sensors (HX711 + calibration)
-  sensors_init();
+    // Configure button pull modes up-front
+    buttons_setupPins();
 
-  // Configure button pull modes up-front
-  buttons_setupPins();
+    // D2 held at boot: keep an audio clip from this wake's capture
+    if (buttons_pressed(SEL_BTN_PIN, SEL_BTN_ACTIVE_LEVEL)) g_recordClip = true;
 
-  // Boot button actions: hold for clear or calibrate
-  bool resetProv = false;
-  uint32_t heldCal = buttons_measureHoldMs(CAL_BTN_PIN, 9000, CAL_BTN_INPUT_MODE, CAL_BTN_ACTIVE_LEVEL);
-  if (heldCal >= CALIBRATE_HOLD_MS) {
-    Serial.println("Entering HX711 calibration mode (long hold)");
-    sensors_runHX711Calibration();
-  } else if (bootLongPressToClear(CLEAR_PROV_HOLD_MS)) {
-    resetProv = true;
+    // Boot button actions: hold for clear or calibrate
+    uint32_t heldCal = buttons_measureHoldMs(CAL_BTN_PIN, 9000, CAL_BTN_INPUT_MODE, CAL_BTN_ACTIVE_LEVEL);
+    if (heldCal >= CALIBRATE_HOLD_MS) {
+      LOG_I("Entering HX711 calibration mode (long hold)");
+      sensors_runHX711Calibration();
+    } else if (bootLongPressToClear(CLEAR_PROV_HOLD_MS)) {
+      resetProv = true;
+      display_fillScreen(ST77XX_BLACK);
+      display_printAt("HiveSync", TFT_LINE_1, ST77XX_YELLOW);
+      display_printAt("Clearing provisioning...", TFT_LINE_2, ST77XX_RED);
+      display_drawBatteryTopRight();
+      LOG_I("Long press detected on D0: clearing provisioning");
+      delay(300);
+    }
+  }
+  if (g_recordClip) LOG_I("Audio clip recording armed for this wake");
+
+  // Budget starts after the interactive boot UI (calibration waits on the user)
+  supervisor_begin(g_headless, HIVESYNC_ROLE == HIVESYNC_ROLE_GATEWAY);
+
+#if HIVESYNC_ROLE == HIVESYNC_ROLE_LEAF
+  // Leaves never join Wi-Fi; records go to the apiary gateway over ESP-NOW
+  return;
+#endif
+
+#if HIVESYNC_ROLE == HIVESYNC_ROLE_STANDALONE
+  // Records go out over serial: Wi-Fi only serves provisioning (power-on and
+  // button wakes) and SNTP when the clock model has drifted too far
+  g_wifiOn = !g_headless || timekeeping_needsSync();
+  if (g_wifiOn) startProvisioning(resetProv);
+  // First sample while Wi-Fi associates in the background: temperature and
+  // weight need no network. Audio, SNTP and the record wait for loop().
+  g_tempOK = measureSensors(g_rec, g_tasks, g_tempC, g_weightLine, sizeof(g_weightLine), g_hxUsable);
+  g_sampleMs = millis();
+  // Waiting for an IP is bounded by the Wi-Fi stage deadline (see loop())
+  if (g_wifiOn) supervisor_stage(WAKE_WIFI);
+#else
+  startProvisioning(resetProv);
+  supervisor_stage(WAKE_WIFI);
+#endif
+}
+
+// Record/analyze 60s of audio into defined FFT bands; skipped when the wake
+// budget cannot cover the whole capture. With WEIGHT_ACTIVITY the load cell
+// is streamed alongside, unless the HX711 just failed to read or
+// WEIGHT_ACTIVITY_STREAM is 0.
+static void measureAudio(HiveRecord &rec, bool hxUsable) {
+  if (!supervisor_canStart(WAKE_AUDIO, AUDIO_CAPTURE_MS + 2000)) return;
+  float bands[AUDIO_BANDS] = {0};
+  AudioStats audioStats;
+  AudioSpectrogram *spectro = nullptr;
+#if AUDIO_SPECTROGRAM
+  AudioSpectrogram spectroOut = {g_spectroBuf, sizeof(g_spectroBuf), 0, 0, false};
+  spectro = &spectroOut;
+#endif
+  display_printAt("Audio: 60s capture...", TFT_LINE_5, ST77XX_WHITE);
+  bool clipOK = g_recordClip && audio_clip_begin(AUDIO_CLIP_PATH, AUDIO_CLIP_SECONDS);
+#if WEIGHT_ACTIVITY
+  const bool activity = WEIGHT_ACTIVITY_STREAM && hxUsable && sensors_beginHX711Stream(g_activity);
+  LOG_I("Activity: HX711 %s during capture", activity ? "streamed" : "not streamed");
+#else
+  (void)hxUsable;
+#endif
+  bool audioOK = analyzeINMP441Bins60s(bands, &audioStats, spectro);
+#if WEIGHT_ACTIVITY
+  if (activity) {
+    sensors_endHX711Stream();
+    logActivity();
+  }
+#endif
+  if (clipOK) {
+    AudioClipStats clip;
+    bool saved = audio_clip_end(&clip);
+    const float secs = (float)clip.samples / (float)CLIP_SAMPLE_RATE;
+    LOG_I("Clip %s: %.1f s, %u bytes, %u blocks dropped, slowest write %u ms",
+          saved ? AUDIO_CLIP_PATH : "failed", secs, (unsigned)clip.bytes,
+          (unsigned)clip.droppedBlocks, (unsigned)clip.maxWriteMs);
+    if (clip.samples) {
+      LOG_I("Clip encode: %.1f us per output sample (%.1f%% of real time)",
+            (float)clip.encodeUs / (float)clip.samples,
+            (float)clip.encodeUs / (secs * 10000.0f));
+    }
+  }
+  if (audioOK) {
+    // Print named bins in requested ranges
+    LOG_I("s_bin098_146Hz: %.2f", bands[0]);
+    LOG_I("s_bin146_195Hz: %.2f", bands[1]);
+    LOG_I("s_bin195_244Hz: %.2f", bands[2]);
+    LOG_I("s_bin244_293Hz: %.2f", bands[3]);
+    LOG_I("s_bin293_342Hz: %.2f", bands[4]);
+    LOG_I("s_bin342_391Hz: %.2f", bands[5]);
+    LOG_I("s_bin391_439Hz: %.2f", bands[6]);
+    LOG_I("s_bin439_488Hz: %.2f", bands[7]);
+    LOG_I("s_bin488_537Hz: %.2f", bands[8]);
+    LOG_I("s_bin537_586Hz: %.2f", bands[9]);
+    // Streaming per-band distribution over the capture
+    for (int b = 0; b < AUDIO_BANDS; ++b) {
+      const AudioBandStats &bs = audioStats.bands[b];
+      LOG_I("s_band%d p10/p50/p90: %.2f/%.2f/%.2f max: %.2f var: %.2f",
+            b, bs.p10, bs.p50, bs.p90, bs.max, bs.variance);
+    }
+    LOG_I("s_peakHz: %.1f (strongest %.1f Hz)", audioStats.peakHz, audioStats.peakMaxHz);
+    LOG_I("s_centroidHz: %.1f", audioStats.centroidHz);
+    LOG_I("s_flatness: %.3f", audioStats.flatness);
+    LOG_I("Audio stats overhead: %.0f us/frame avg, %u us max (%u frames)",
+          audioStats.statsUsPerFrame, (unsigned)audioStats.statsUsMax, (unsigned)audioStats.frames);
+#if AUDIO_SPECTROGRAM
+    dumpSpectrogram(*spectro);
+#endif
+    rec.flags |= HIVEREC_F_AUDIO;
+    for (int b = 0; b < AUDIO_BANDS; ++b) rec.bandsCdB[b] = record_bandToCdB(bands[b]);
+  } else {
+    LOG_W("I2S microphone not initialized or stalled (check pins/wiring). Skipping audio.");
+  }
+}
+
+// Run the quick sensor tasks (temperature, weight, plus the battery); log them
+// and start rec. Returns whether the temperature read succeeded; weightLine
+// gets the display text, hxUsable whether the load cell may be streamed.
+static bool measureSensors(HiveRecord &rec, uint32_t tasks, float &tempC, char *weightLine, size_t weightLen,
+                           bool &hxUsable) {
+  LOG_I("Boot to first sample: %lu ms (%s wake)", (unsigned long)millis(), wakeCauseName(g_wakeCause));
+  record_init(rec);
+  rec.timestamp = timekeeping_nowUnix();
+  if (rec.timestamp) rec.flags |= HIVEREC_F_TIME;
+  snprintf(weightLine, weightLen, "Wt: --");
+  bool ok = (tasks & TASK_BIT(TASK_TEMP)) && supervisor_canStart(WAKE_TEMP, 1) && sensors_readDS18B20C(tempC);
+  if (!(tasks & TASK_BIT(TASK_TEMP))) {
+    // not scheduled this wake
+  } else if (ok) {
+    LOG_I("DS18B20 temperature: %.2f C", tempC);
+    rec.flags |= HIVEREC_F_TEMP;
+    rec.tempCx100 = (int16_t)lroundf(tempC * 100.0f);
+  } else {
+    LOG_W("No DS18B20 detected or read failed.");
+  }
+
+  long hxRaw = 0;
+  bool hxHasUnits = false;
+  float hxUnits = 0.0f;
+  bool hxOK = (tasks & TASK_BIT(TASK_WEIGHT)) && supervisor_canStart(WAKE_WEIGHT, 1) &&
+              sensors_readHX711(hxRaw, hxHasUnits, hxUnits, 10);
+  if (!(tasks & TASK_BIT(TASK_WEIGHT))) {
+    // not scheduled this wake
+  } else if (hxOK) {
+    rec.flags |= HIVEREC_F_WEIGHT;
+    if (hxHasUnits) {
+      snprintf(weightLine, weightLen, "Wt: %.2f %s", hxUnits, HX711_UNITS_LABEL);
+      LOG_I("HX711: %.2f %s (raw %ld)", hxUnits, HX711_UNITS_LABEL, hxRaw);
+      rec.flags |= HIVEREC_F_UNITS;
+      rec.weight = (int32_t)lroundf(hxUnits * 100.0f);
+    } else {
+      snprintf(weightLine, weightLen, "Wt raw: %ld", hxRaw);
+      LOG_I("HX711 raw: %ld (calibrate to get units)", hxRaw);
+      rec.weight = (int32_t)hxRaw;
+    }
+  } else {
+    snprintf(weightLine, weightLen, "HX711 not ready");
+    LOG_W("HX711 not ready or not connected.");
+  }
+
+  float battPct = 0.0f, battV = 0.0f;
+  if (battery_read(battPct, battV)) {
+    rec.flags |= HIVEREC_F_BATTERY;
+    rec.batteryPct = (uint8_t)lroundf(battPct);
+    rec.batteryMv = (uint16_t)lroundf(battV * 1000.0f);
+  }
+  hxUsable = hxOK || !(tasks & TASK_BIT(TASK_WEIGHT));
+  return ok;
+}
+
+// Stages given up so far (a late finish included), and the running overrun
+// count, travel with the record
+static void finishRecord(HiveRecord &rec) {
+  supervisor_ok();
+  rec.faults = supervisor_faults();
+  rec.overruns = supervisor_overruns();
+}
+
+// Run the given sensor tasks, audio included, and fill rec
+static bool measureTasks(HiveRecord &rec, uint32_t tasks, float &tempC, char *weightLine, size_t weightLen) {
+  bool hxUsable = false;
+  const bool ok = measureSensors(rec, tasks, tempC, weightLine, weightLen, hxUsable);
+  if (tasks & TASK_BIT(TASK_AUDIO)) measureAudio(rec, hxUsable);
+  finishRecord(rec);
+  return ok;
+}
+
+static void showReadings(bool tempOK, float tempC, const char *weightLine) {
+  if (tempOK) {
+    display_showSensorsAndSleep(tempC, weightLine);
+  } else {
     display_fillScreen(ST77XX_BLACK);
     display_printAt("HiveSync", TFT_LINE_1, ST77XX_YELLOW);
-    display_printAt("Clearing provisioning...", TFT_LINE_2, ST77XX_RED);
+    display_printAt("Temp sensor missing", TFT_LINE_2, ST77XX_RED);
+    display_printAt(String(weightLine), TFT_LINE_3, ST77XX_WHITE);
+    display_printAt("Sleeping...", TFT_LINE_4, ST77XX_CYAN);
     display_drawBatteryTopRight();
-    Serial.println("Long press detected on D0: clearing provisioning");
-    delay(300);
   }
+}
 
-  // Register provisioning/WiFi events
-  WiFi.onEvent(SysProvEvent);
-
-  // Start BLE provisioning. Credentials persist via NVS by default.
-  // Using BLE scheme with security 1 (PoP) and our custom service name / PoP.
-  uint8_t uuid[16] = {0xb4, 0xdf, 0x5a, 0x1c, 0x3f, 0x6b, 0xf4, 0xbf,
-                      0xea, 0x4a, 0x82, 0x03, 0x04, 0x90, 0x1a, 0x02};
-  WiFiProv.beginProvision(
-      WIFI_PROV_SCHEME_BLE,
-      WIFI_PROV_SCHEME_HANDLER_FREE_BTDM,
-      WIFI_PROV_SECURITY_1,
-      g_pop.c_str(),
-      g_deviceName.c_str(),
-      nullptr,
-      uuid,
-      resetProv  // clear provisioning when D0 held during boot
-  );
+// Sleep until the earliest task deadline
+static void enterDeepSleep() {
+  const uint32_t sleepS = sched_sleepS(g_sched, timekeeping_rtcSeconds(), 1);
+  esp_sleep_enable_timer_wakeup((uint64_t)sleepS * 1000000ULL);
+  // D0 wakes into the full UI path; the timer wake stays headless
+  if (rtc_gpio_is_valid_gpio((gpio_num_t)BOOT_BTN_PIN)) {
+    if (BOOT_BTN_INPUT_MODE == INPUT_PULLUP) rtc_gpio_pullup_en((gpio_num_t)BOOT_BTN_PIN);
+    esp_sleep_enable_ext0_wakeup((gpio_num_t)BOOT_BTN_PIN, BOOT_BTN_ACTIVE_LEVEL);
+  }
+  supervisor_end();
+  // Power down peripherals where possible
+  sensors_powerDown();
+  display_backlight(false);
+  LOG_I("Entering deep sleep for %lu s (%lu log messages dropped)...", (unsigned long)sleepS,
+        (unsigned long)log_dropped());
+  // Bounded: a slow or detached USB CDC must not keep the device awake
+  log_flush(LOG_SLEEP_FLUSH_MS);
+  esp_deep_sleep_start();
 }
 
-void loop() {
-  // After WiFi got IP, perform one sensor read then deep sleep
-  if (g_pendingSampleAfterIP && !g_sampleDone) {
-    g_sampleDone = true;
-    float tempC = NAN;
-    bool ok = sensors_readDS18B20C(tempC);
-    if (ok) {
-      Serial.printf("DS18B20 temperature: %.2f C\n", tempC);
-    } else {
-      Serial.println("No DS18B20 detected or read failed.");
+#if HIVESYNC_ROLE == HIVESYNC_ROLE_LEAF
+// Deliver rec to the gateway: cached channel/gateway first, then a broadcast sweep
+static bool leafUplink(const HiveRecord &rec) {
+  if (g_leaf.magic != LEAF_LINK_MAGIC || g_leaf.channel < 1 || g_leaf.channel > 13) {
+    // Fresh power-up: avoid colliding with the sequence the gateway last saw from us
+    memset(&g_leaf, 0, sizeof(g_leaf));
+    g_leaf.magic = LEAF_LINK_MAGIC;
+    g_leaf.seq = (uint16_t)esp_random();
+    g_leaf.channel = HIVELINK_CHANNEL;
+  }
+  const uint16_t seq = ++g_leaf.seq;
+  supervisor_stage(WAKE_UPLINK);
+  EspNowTransport radio;
+  supervisor_radio(true);
+  if (!radio.begin(g_leaf.channel)) {
+    supervisor_radio(false);
+    return false;
+  }
+  HiveLinkLeaf leaf(radio);
+  if (g_leaf.gatewayKnown) leaf.setGateway(g_leaf.gateway);
+  const uint32_t t0 = millis();
+  bool ok = leaf.send((const uint8_t *)&rec, sizeof(rec), seq, HIVELINK_ACK_TIMEOUT_MS, HIVELINK_RETRIES);
+  for (uint8_t ch = 1; !ok && ch <= 13 && supervisor_ok(); ++ch) {
+    leaf.clearGateway();
+    radio.setChannel(ch);
+    if (leaf.send((const uint8_t *)&rec, sizeof(rec), seq, HIVELINK_ACK_TIMEOUT_MS, 1)) {
+      ok = true;
+      g_leaf.channel = ch;
     }
+  }
+  if (ok) {
+    memcpy(g_leaf.gateway, leaf.gateway(), 6);
+    g_leaf.gatewayKnown = true;
+  }
+  LOG_I("HiveLink: record seq %u %s on ch %u in %lu ms", seq, ok ? "acked" : "NOT delivered",
+        g_leaf.channel, (unsigned long)(millis() - t0));
+  radio.end();
+  supervisor_radio(false);
+  return ok;
+}
+#endif
 
-    long hxRaw = 0;
-    bool hxHasUnits = false;
-    float hxUnits = 0.0f;
-    bool hxOK = sensors_readHX711(hxRaw, hxHasUnits, hxUnits, 10);
-    char weightLine[40];
-    if (hxOK) {
-      if (hxHasUnits) {
-        snprintf(weightLine, sizeof(weightLine), "Wt: %.2f %s", hxUnits, HX711_UNITS_LABEL);
-        Serial.printf("HX711: %.2f %s (raw %ld)\n", hxUnits, HX711_UNITS_LABEL, hxRaw);
-      } else {
-        snprintf(weightLine, sizeof(weightLine), "Wt raw: %ld", hxRaw);
-        Serial.printf("HX711 raw: %ld (calibrate to get units)\n", hxRaw);
+#if HIVESYNC_ROLE != HIVESYNC_ROLE_LEAF
+// Report the rollup buckets that closed since the last record, then fold rec in
+static void rollupUplink(const HiveRecord &rec) {
+  static const char *const kLabels[ROLLUP_KINDS] = {"ROLLUP hour", "ROLLUP day"};
+  const uint32_t now = timekeeping_nowUnix();
+  RollupBucket b;
+  for (uint8_t k = 0; k < ROLLUP_KINDS; ++k) {
+    while (rollup_take(g_rollup, (RollupKind)k, now, &b, 1)) record_printRollup(kLabels[k], b);
+  }
+  RollupSample sample;
+  record_toRollup(rec, sample);
+  rollup_add(g_rollup, sample);
+}
+#endif
+
+#if HIVESYNC_ROLE == HIVESYNC_ROLE_GATEWAY
+// One uplink for the whole apiary: own record plus everything the leaves delivered
+static void gatewayUplink(const HiveRecord &self) {
+  supervisor_stage(WAKE_UPLINK);
+  static HiveLinkSlot batch[HIVELINK_GATEWAY_SLOTS];
+  const size_t n = g_gateway.takeBatch(batch, HIVELINK_GATEWAY_SLOTS);
+  const HiveLinkGatewayStats st = g_gateway.stats();
+  char line[96];
+  snprintf(line, sizeof(line), "UPLINK begin: %u records (%lu rx, %lu dup, %lu dropped, %lu corrupt)",
+           (unsigned)(n + 1), (unsigned long)st.received, (unsigned long)st.duplicates, (unsigned long)st.dropped,
+           (unsigned long)st.corrupt);
+  log_writeLine(line);
+  record_print("UPLINK gateway", self);
+  rollupUplink(self);
+  for (size_t i = 0; i < n; ++i) {
+    char label[32];
+    snprintf(label, sizeof(label), "UPLINK %02X%02X%02X%02X%02X%02X#%u", batch[i].mac[0], batch[i].mac[1],
+             batch[i].mac[2], batch[i].mac[3], batch[i].mac[4], batch[i].mac[5], batch[i].seq);
+    if (batch[i].len == sizeof(HiveRecord)) {
+      HiveRecord rec;
+      memcpy(&rec, batch[i].payload, sizeof(rec));
+      // Leaves have no time source of their own: stamp with the receive time
+      if (!(rec.flags & HIVEREC_F_TIME) && timekeeping_valid()) {
+        rec.timestamp = timekeeping_nowUnix() - (millis() - batch[i].rxMs) / 1000;
+        rec.flags |= HIVEREC_F_TIME;
       }
+      record_print(label, rec);
     } else {
-      snprintf(weightLine, sizeof(weightLine), "HX711 not ready");
-      Serial.println("HX711 not ready or not connected.");
+      snprintf(line, sizeof(line), "%s: unexpected payload (%u bytes)", label, batch[i].len);
+      log_writeLine(line);
     }
+  }
+  log_writeLine("UPLINK end");
+}
+#endif
 
-    // Optionally record/analyze 60s of audio into defined FFT bands
-    float bands[AUDIO_BANDS] = {0};
-    display_printAt("Audio: 60s capture...", TFT_LINE_5, ST77XX_WHITE);
-    bool audioOK = analyzeINMP441Bins60s(bands);
-    if (audioOK) {
-      // Print named bins in requested ranges
-      Serial.printf("s_bin098_146Hz: %.2f\n", bands[0]);
-      Serial.printf("s_bin146_195Hz: %.2f\n", bands[1]);
-      Serial.printf("s_bin195_244Hz: %.2f\n", bands[2]);
-      Serial.printf("s_bin244_293Hz: %.2f\n", bands[3]);
-      Serial.printf("s_bin293_342Hz: %.2f\n", bands[4]);
-      Serial.printf("s_bin342_391Hz: %.2f\n", bands[5]);
-      Serial.printf("s_bin391_439Hz: %.2f\n", bands[6]);
-      Serial.printf("s_bin439_488Hz: %.2f\n", bands[7]);
-      Serial.printf("s_bin488_537Hz: %.2f\n", bands[8]);
-      Serial.printf("s_bin537_586Hz: %.2f\n", bands[9]);
-    } else {
-      Serial.println("I2S microphone not initialized (check pins/wiring). Skipping audio.");
+void loop() {
+  supervisor_feed();
+#if HIVESYNC_ROLE == HIVESYNC_ROLE_LEAF
+  // Measure, hand the record to the gateway and go straight back to sleep
+  if (!g_sampleDone) {
+    g_sampleDone = true;
+    HiveRecord rec;
+    float tempC = NAN;
+    char weightLine[40];
+    bool ok = measureTasks(rec, g_tasks, tempC, weightLine, sizeof(weightLine));
+    completeTasks(g_tasks);
+    leafUplink(rec);
+    showReadings(ok, tempC, weightLine);
+    enterDeepSleep();
+  }
+#elif HIVESYNC_ROLE == HIVESYNC_ROLE_GATEWAY
+  // Stay awake on the AP's channel collecting leaf records; uplink once per interval
+  if (!g_pendingSampleAfterIP && !g_wifiGaveUp && !supervisor_ok()) {
+    // No AP: keep collecting on the default channel, without SNTP
+    g_wifiGaveUp = true;
+  }
+  if (g_pendingSampleAfterIP || g_wifiGaveUp) {
+    if (!g_radioUp) {
+      g_radioUp = g_radio.begin(g_pendingSampleAfterIP ? 0 : HIVELINK_CHANNEL);
+      LOG_I("HiveLink gateway %s on channel %d", g_radioUp ? "listening" : "failed", WiFi.channel());
     }
-
-    // Show readings and sleep
-    if (ok) {
-      display_showSensorsAndSleep(tempC, weightLine);
-    } else {
+    // Tasks are looked at again only once the earliest deadline comes within
+    // the tolerance, not on every loop pass
+    if (g_sampleDone && timekeeping_rtcSeconds() + SCHED_TOLERANCE_S >= g_nextDueS) {
+      g_tasks = scheduleTasks(false);
+      if (!g_tasks) g_nextDueS = sched_nextDueS(g_sched);
+    }
+    if (!g_sampleDone || g_tasks) {
+      // Each cycle gets its own stage deadlines (no wake limit: the gateway never sleeps)
+      if (g_sampleDone) supervisor_begin(true, true);
+      g_sampleDone = true;
+      // Only spend time on SNTP when the clock model says it has drifted too far
+      if (g_pendingSampleAfterIP && timekeeping_needsSync() && supervisor_canStart(WAKE_SNTP, 1)) {
+        timekeeping_syncSntp(min((uint32_t)TIME_SYNC_TIMEOUT_MS, supervisor_remainingMs()));
+      }
+      HiveRecord rec;
+      float tempC = NAN;
+      char weightLine[40];
+      measureTasks(rec, g_tasks, tempC, weightLine, sizeof(weightLine));
+      completeTasks(g_tasks);
+      g_tasks = 0;
+      g_nextDueS = sched_nextDueS(g_sched);
+      gatewayUplink(rec);
+      char line[32];
+      snprintf(line, sizeof(line), "Gateway: %u pending", (unsigned)g_gateway.pending());
       display_fillScreen(ST77XX_BLACK);
       display_printAt("HiveSync", TFT_LINE_1, ST77XX_YELLOW);
-      display_printAt("Temp sensor missing", TFT_LINE_2, ST77XX_RED);
-      display_printAt(String(weightLine), TFT_LINE_3, ST77XX_WHITE);
-      display_printAt("Sleeping 15 min...", TFT_LINE_4, ST77XX_CYAN);
+      display_printAt(String(weightLine), TFT_LINE_2, ST77XX_WHITE);
+      display_printAt(String(line), TFT_LINE_3, ST77XX_CYAN);
       display_drawBatteryTopRight();
+      supervisor_end();
     }
-    const uint64_t sleep_us = 15ULL * 60ULL * 1000000ULL;
-    esp_sleep_enable_timer_wakeup(sleep_us);
-    // Power down peripherals where possible
-    sensors_powerDown();
-    display_backlight(false);
-    Serial.println("Entering deep sleep for 15 minutes...");
-    Serial.flush();
-    delay(250);
-    esp_deep_sleep_start();
   }
+#else
+  // After WiFi got IP (or the Wi-Fi deadline passed, or no Wi-Fi this wake),
+  // finish the record started in setup() then deep sleep
+  if ((g_pendingSampleAfterIP || !g_wifiOn || !supervisor_ok()) && !g_sampleDone) {
+    g_sampleDone = true;
+    // Only keep the radio up for SNTP when the clock model says it has drifted too far
+    if (g_pendingSampleAfterIP && timekeeping_needsSync() && supervisor_canStart(WAKE_SNTP, 1) &&
+        timekeeping_syncSntp(min((uint32_t)TIME_SYNC_TIMEOUT_MS, supervisor_remainingMs()))) {
+      // Restamp the sample with the synced clock
+      g_rec.timestamp = timekeeping_nowUnix() - (millis() - g_sampleMs) / 1000;
+      g_rec.flags |= HIVEREC_F_TIME;
+    }
+    stopWiFi();
+    if (g_tasks & TASK_BIT(TASK_AUDIO)) measureAudio(g_rec, g_hxUsable);
+    finishRecord(g_rec);
+    completeTasks(g_tasks);
+    supervisor_stage(WAKE_UPLINK);
+    record_print("record", g_rec);
+    rollupUplink(g_rec);
+    // Show readings and sleep
+    showReadings(g_tempOK, g_tempC, g_weightLine);
+    enterDeepSleep();
+  }
+#endif
   delay(50);
 }
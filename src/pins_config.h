@@ -37,6 +37,7 @@
 #ifndef HX711_SCK_PIN
 #define HX711_SCK_PIN 11
 #endif
+// HX711_RATE_PIN: define if RATE is wired to a GPIO (high = 80 SPS)
 
 // INMP441 I2S microphone pins
 #ifndef I2S_WS_PIN
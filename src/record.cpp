@@ -0,0 +1,96 @@
+#include "record.h"
+
+#include "log.h"
+#include "sensors.h"
+
+void record_init(HiveRecord &rec) {
+  memset(&rec, 0, sizeof(rec));
+  rec.version = HIVE_RECORD_VERSION;
+}
+
+uint16_t record_bandToCdB(float magnitude) {
+  if (!(magnitude > 1.0f)) return 0;
+  const float cdb = 2000.0f * log10f(magnitude);
+  if (cdb >= 65535.0f) return 65535;
+  return (uint16_t)(cdb + 0.5f);
+}
+
+float record_cdBToBand(uint16_t cdB) {
+  return cdB ? powf(10.0f, (float)cdB / 2000.0f) : 0.0f;
+}
+
+void record_print(const char *label, const HiveRecord &rec) {
+  char line[200];
+  int n = snprintf(line, sizeof(line), "%s:", label);
+  if (rec.flags & HIVEREC_F_TIME) {
+    n += snprintf(line + n, sizeof(line) - n, " t=%lu", (unsigned long)rec.timestamp);
+  }
+  if (rec.flags & HIVEREC_F_TEMP) {
+    n += snprintf(line + n, sizeof(line) - n, " T=%.2fC", rec.tempCx100 / 100.0f);
+  }
+  if (rec.flags & HIVEREC_F_WEIGHT) {
+    if (rec.flags & HIVEREC_F_UNITS) {
+      n += snprintf(line + n, sizeof(line) - n, " W=%.2f%s", rec.weight / 100.0f, HX711_UNITS_LABEL);
+    } else {
+      n += snprintf(line + n, sizeof(line) - n, " Wraw=%ld", (long)rec.weight);
+    }
+  }
+  if (rec.flags & HIVEREC_F_BATTERY) {
+    n += snprintf(line + n, sizeof(line) - n, " B=%u%%/%umV", rec.batteryPct, rec.batteryMv);
+  }
+  if (rec.flags & HIVEREC_F_AUDIO) {
+    n += snprintf(line + n, sizeof(line) - n, " dB=");
+    for (int b = 0; b < AUDIO_BANDS && n < (int)sizeof(line) - 8; ++b) {
+      n += snprintf(line + n, sizeof(line) - n, "%s%.1f", b ? "," : "", rec.bandsCdB[b] / 100.0f);
+    }
+  }
+  if (rec.faults || rec.overruns) {
+    n += snprintf(line + n, sizeof(line) - n, " F=0x%02X/%u", rec.faults, rec.overruns);
+  }
+  log_writeLine(line);
+}
+
+void record_toRollup(const HiveRecord &rec, RollupSample &out) {
+  memset(&out, 0, sizeof(out));
+  out.timestamp = (rec.flags & HIVEREC_F_TIME) ? rec.timestamp : 0;
+  out.hasTemp = rec.flags & HIVEREC_F_TEMP;
+  out.hasWeight = rec.flags & HIVEREC_F_WEIGHT;
+  out.weightUnits = rec.flags & HIVEREC_F_UNITS;
+  out.hasBattery = rec.flags & HIVEREC_F_BATTERY;
+  out.hasBands = rec.flags & HIVEREC_F_AUDIO;
+  out.tempCx100 = rec.tempCx100;
+  out.weight = rec.weight;
+  out.batteryMv = rec.batteryMv;
+  memcpy(out.bandsCdB, rec.bandsCdB, sizeof(out.bandsCdB));
+}
+
+void record_printRollup(const char *label, const RollupBucket &b) {
+  char line[200];
+  int n = snprintf(line, sizeof(line), "%s: t=%lu n=%u", label, (unsigned long)b.startS, b.records);
+  if (b.tempCx100.count) {
+    n += snprintf(line + n, sizeof(line) - n, " T=%.2f/%.2f/%.2fC", b.tempCx100.min / 100.0f,
+                  b.tempCx100.mean / 100.0f, b.tempCx100.max / 100.0f);
+  }
+  if (b.weight.count) {
+    int32_t delta = 0;
+    rollup_weightDelta(b, delta);
+    if (b.flags & ROLLUP_F_UNITS) {
+      n += snprintf(line + n, sizeof(line) - n, " W=%.2f/%.2f/%.2f%s dW=%+.2f", b.weight.min / 100.0f,
+                    b.weight.mean / 100.0f, b.weight.max / 100.0f, HX711_UNITS_LABEL, delta / 100.0f);
+    } else {
+      n += snprintf(line + n, sizeof(line) - n, " Wraw=%ld/%.0f/%ld dWraw=%+ld", (long)b.weight.min,
+                    b.weight.mean, (long)b.weight.max, (long)delta);
+    }
+  }
+  if (b.batteryMv.count) {
+    n += snprintf(line + n, sizeof(line) - n, " B=%ld/%.0f/%ldmV", (long)b.batteryMv.min, b.batteryMv.mean,
+                  (long)b.batteryMv.max);
+  }
+  if (b.bandsCdB[0].count) {
+    n += snprintf(line + n, sizeof(line) - n, " dB=");
+    for (int i = 0; i < ROLLUP_BANDS && n < (int)sizeof(line) - 8; ++i) {
+      n += snprintf(line + n, sizeof(line) - n, "%s%.1f", i ? "," : "", b.bandsCdB[i].mean / 100.0f);
+    }
+  }
+  log_writeLine(line);
+}
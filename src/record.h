@@ -0,0 +1,47 @@
+// Compact per-wake measurement record (sent over ESP-NOW and batched for uplink)
+#pragma once
+
+#include <Arduino.h>
+#include "audio_inmp441.h"
+#include "rollup.h"
+
+static_assert(ROLLUP_BANDS == AUDIO_BANDS, "ROLLUP_BANDS and AUDIO_BANDS disagree");
+
+#define HIVE_RECORD_VERSION 3
+
+// Validity/failure flags
+#define HIVEREC_F_TEMP      0x01  // tempCx100 valid
+#define HIVEREC_F_WEIGHT    0x02  // weight valid
+#define HIVEREC_F_UNITS     0x04  // weight in calibrated units x100 (else raw counts)
+#define HIVEREC_F_BATTERY   0x08  // battery fields valid
+#define HIVEREC_F_AUDIO     0x10  // bands valid
+#define HIVEREC_F_TIME      0x20  // timestamp valid
+
+struct __attribute__((packed)) HiveRecord {
+  uint8_t version;
+  uint8_t flags;
+  uint32_t timestamp;  // Unix seconds at the start of the measurement
+  int16_t tempCx100;
+  int32_t weight;
+  uint8_t batteryPct;
+  uint16_t batteryMv;
+  uint16_t bandsCdB[AUDIO_BANDS];  // band magnitude in 0.01 dB (20*log10)
+  uint8_t faults;                  // stages abandoned this wake (WAKE_FAULT bits, wake_budget.h)
+  uint8_t overruns;                // stage overruns/budget cuts since power-on (saturating)
+};
+
+// Reset to an empty record (no valid fields)
+void record_init(HiveRecord &rec);
+
+// Convert band magnitudes to/from the record's centi-dB encoding
+uint16_t record_bandToCdB(float magnitude);
+float record_cdBToBand(uint16_t cdB);
+
+// Human-readable single line, prefixed with the given label (e.g. a MAC)
+void record_print(const char *label, const HiveRecord &rec);
+
+// Rollup input from a record's valid fields
+void record_toRollup(const HiveRecord &rec, RollupSample &out);
+
+// Single line per rollup bucket: min/mean/max per field, weight delta, band means
+void record_printRollup(const char *label, const RollupBucket &b);
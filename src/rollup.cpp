@@ -0,0 +1,157 @@
+#include "rollup.h"
+
+#include <string.h>
+
+void rollup_init(RollupState &s) {
+  memset(&s, 0, sizeof(s));
+  s.magic = ROLLUP_MAGIC;
+}
+
+bool rollup_valid(const RollupState &s) {
+  return s.magic == ROLLUP_MAGIC;
+}
+
+uint32_t rollup_periodS(RollupKind kind) {
+  return kind == ROLLUP_DAY ? ROLLUP_DAY_S : ROLLUP_HOUR_S;
+}
+
+// Day buckets follow the local day; hours stay on UTC hours
+static int32_t offsetS(RollupKind kind) {
+  return kind == ROLLUP_DAY ? (int32_t)ROLLUP_DAY_OFFSET_S : 0;
+}
+
+uint32_t rollup_bucketStart(RollupKind kind, uint32_t t) {
+  const uint32_t period = rollup_periodS(kind);
+  const int32_t off = offsetS(kind);
+  return (t + off) / period * period - off;
+}
+
+static RollupBucket *ring(RollupState &s, RollupKind kind, size_t &n) {
+  n = kind == ROLLUP_DAY ? ROLLUP_DAYS : ROLLUP_HOURS;
+  return kind == ROLLUP_DAY ? s.days : s.hours;
+}
+
+static void statAdd(RollupStat &st, int32_t v) {
+  if (!st.count) {
+    st.min = st.max = v;
+    st.mean = (float)v;
+    st.count = 1;
+    return;
+  }
+  if (v < st.min) st.min = v;
+  if (v > st.max) st.max = v;
+  if (st.count < UINT16_MAX) st.count++;
+  st.mean += ((float)v - st.mean) / (float)st.count;
+}
+
+static void bucketAdd(RollupBucket &b, const RollupSample &r) {
+  if (b.records < UINT16_MAX) b.records++;
+  if (r.hasTemp) statAdd(b.tempCx100, r.tempCx100);
+  if (r.hasBattery) statAdd(b.batteryMv, r.batteryMv);
+  if (r.hasBands) {
+    for (int i = 0; i < ROLLUP_BANDS; ++i) statAdd(b.bandsCdB[i], r.bandsCdB[i]);
+  }
+  if (r.hasWeight) {
+    // Calibration changed mid-bucket: earlier weights are not comparable
+    if (b.weight.count && ((b.flags & ROLLUP_F_UNITS) != 0) != r.weightUnits) b.weight.count = 0;
+    if (!b.weight.count) {
+      b.flags = r.weightUnits ? (b.flags | ROLLUP_F_UNITS) : (b.flags & ~ROLLUP_F_UNITS);
+      b.weightFirst = b.weightLast = r.weight;
+      b.weightFirstS = b.weightLastS = r.timestamp;
+    } else if (r.timestamp < b.weightFirstS) {
+      b.weightFirst = r.weight;
+      b.weightFirstS = r.timestamp;
+    } else if (r.timestamp >= b.weightLastS) {
+      b.weightLast = r.weight;
+      b.weightLastS = r.timestamp;
+    }
+    statAdd(b.weight, r.weight);
+  }
+}
+
+static bool fold(RollupState &s, RollupKind kind, const RollupSample &r) {
+  size_t n;
+  RollupBucket *slots = ring(s, kind, n);
+  const uint32_t period = rollup_periodS(kind);
+  const uint32_t start = rollup_bucketStart(kind, r.timestamp);
+  if (start <= s.takenS[kind]) {
+    // Bucket already reported (or an empty one older than it)
+    s.lost[kind]++;
+    return false;
+  }
+  RollupBucket &b = slots[(r.timestamp + offsetS(kind)) / period % n];
+  if (b.startS != start) {
+    if (b.records && b.startS > start) {
+      // Slot already holds a newer bucket: too late for this ring
+      s.lost[kind]++;
+      return false;
+    }
+    // Stale slot; its records are lost if it was never taken
+    if (b.records && b.startS > s.takenS[kind]) s.lost[kind] += b.records;
+    memset(&b, 0, sizeof(b));
+    b.startS = start;
+  }
+  bucketAdd(b, r);
+  return true;
+}
+
+// The clock stepped back to t: buckets that start after t belong to the old
+// timeline. Drop them and let the new timeline report its own; the bucket
+// containing t keeps its records.
+static void stepBack(RollupState &s, uint32_t t) {
+  s.clockJumps++;
+  for (uint8_t k = 0; k < ROLLUP_KINDS; ++k) {
+    const RollupKind kind = (RollupKind)k;
+    size_t n;
+    RollupBucket *slots = ring(s, kind, n);
+    for (size_t i = 0; i < n; ++i) {
+      if (!slots[i].records || slots[i].startS <= t) continue;
+      if (slots[i].startS > s.takenS[kind]) s.lost[kind] += slots[i].records;
+      memset(&slots[i], 0, sizeof(slots[i]));
+    }
+    // Anything up to t's bucket was already taken if a later one was
+    const uint32_t start = rollup_bucketStart(kind, t);
+    if (s.takenS[kind] > start) s.takenS[kind] = start;
+  }
+  s.newestS = t;
+}
+
+bool rollup_add(RollupState &s, const RollupSample &r) {
+  if (!rollup_valid(s)) rollup_init(s);
+  if (r.timestamp < ROLLUP_MIN_VALID_S) {
+    s.untimed++;
+    return false;
+  }
+  if (s.newestS && r.timestamp + ROLLUP_MAX_BACKSTEP_S < s.newestS) stepBack(s, r.timestamp);
+  if (r.timestamp > s.newestS) s.newestS = r.timestamp;
+  const bool hour = fold(s, ROLLUP_HOUR, r);
+  const bool day = fold(s, ROLLUP_DAY, r);
+  return hour || day;
+}
+
+size_t rollup_take(RollupState &s, RollupKind kind, uint32_t nowS, RollupBucket *out, size_t max) {
+  if (!rollup_valid(s)) return 0;
+  size_t n;
+  RollupBucket *slots = ring(s, kind, n);
+  const uint32_t period = rollup_periodS(kind);
+  size_t count = 0;
+  // Rings are tiny: repeatedly pick the oldest closed, untaken bucket
+  while (count < max) {
+    const RollupBucket *next = nullptr;
+    for (size_t i = 0; i < n; ++i) {
+      const RollupBucket &b = slots[i];
+      if (!b.records || b.startS <= s.takenS[kind] || b.startS + period > nowS) continue;
+      if (!next || b.startS < next->startS) next = &b;
+    }
+    if (!next) break;
+    out[count++] = *next;
+    s.takenS[kind] = next->startS;
+  }
+  return count;
+}
+
+bool rollup_weightDelta(const RollupBucket &b, int32_t &delta) {
+  if (b.weight.count < 2) return false;
+  delta = b.weightLast - b.weightFirst;
+  return true;
+}
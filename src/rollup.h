@@ -0,0 +1,115 @@
+// Incremental hourly/daily rollups of per-wake records
+// Portable (no Arduino dependencies) so months of data can be simulated on the host.
+//
+// Each record is folded into the bucket for its hour and its day as it
+// arrives: running min/max/mean/count per field plus the first and last
+// weight for the bucket's weight delta. Buckets sit in fixed rings indexed by
+// time (slot = bucket number % ring size), so memory is constant, hours with
+// no wakes simply have no bucket, and a slot whose stored start does not match
+// is stale and reused. Closed buckets are taken once, oldest first, for the
+// uplink; records that can no longer be reported (their bucket was already
+// taken, overwritten before it was taken, or from the old timeline after a
+// backward clock jump) are counted rather than silently lost.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ROLLUP_MAGIC 0x524F4C4CUL  // "ROLL"
+
+// Ring sizes, including the open bucket. Kept in RTC memory: ~230 bytes each.
+#ifndef ROLLUP_HOURS
+#define ROLLUP_HOURS 6
+#endif
+#ifndef ROLLUP_DAYS
+#define ROLLUP_DAYS 7
+#endif
+// Audio bands per record (must match AUDIO_BANDS)
+#ifndef ROLLUP_BANDS
+#define ROLLUP_BANDS 10
+#endif
+// Local day boundary: seconds east of UTC
+#ifndef ROLLUP_DAY_OFFSET_S
+#define ROLLUP_DAY_OFFSET_S 0
+#endif
+// A record stamped this far behind the newest one means the clock stepped back
+#ifndef ROLLUP_MAX_BACKSTEP_S
+#define ROLLUP_MAX_BACKSTEP_S (60UL * 60UL)
+#endif
+// Timestamps before this (2020-09-13) are treated as "no time"
+#define ROLLUP_MIN_VALID_S 1600000000UL
+
+#define ROLLUP_HOUR_S 3600UL
+#define ROLLUP_DAY_S  86400UL
+
+enum RollupKind : uint8_t { ROLLUP_HOUR, ROLLUP_DAY, ROLLUP_KINDS };
+
+// Bucket flags
+#define ROLLUP_F_UNITS 0x01  // weight in calibrated units x100 (else raw counts)
+
+// One input record, in the record's integer encodings
+struct RollupSample {
+  uint32_t timestamp;  // Unix seconds, 0 if unknown
+  bool hasTemp;
+  bool hasWeight;
+  bool weightUnits;
+  bool hasBattery;
+  bool hasBands;
+  int16_t tempCx100;
+  int32_t weight;
+  uint16_t batteryMv;
+  uint16_t bandsCdB[ROLLUP_BANDS];
+};
+
+struct RollupStat {
+  int32_t min;
+  int32_t max;
+  float mean;
+  uint16_t count;
+};
+
+struct RollupBucket {
+  uint32_t startS;        // Unix seconds; 0 = unused slot
+  uint16_t records;       // records folded in
+  uint8_t flags;
+  uint32_t weightFirstS;  // timestamps of the first and last weight
+  uint32_t weightLastS;
+  int32_t weightFirst;
+  int32_t weightLast;
+  RollupStat tempCx100;
+  RollupStat weight;
+  RollupStat batteryMv;
+  RollupStat bandsCdB[ROLLUP_BANDS];
+};
+
+// Kept in RTC memory across deep sleep
+struct RollupState {
+  uint32_t magic;
+  uint32_t newestS;                  // latest record timestamp folded in
+  uint32_t takenS[ROLLUP_KINDS];     // start of the newest bucket taken
+  uint32_t lost[ROLLUP_KINDS];       // records missing from taken buckets
+  uint32_t untimed;                  // records without a usable timestamp
+  uint32_t clockJumps;               // backward clock steps seen
+  RollupBucket hours[ROLLUP_HOURS];
+  RollupBucket days[ROLLUP_DAYS];
+};
+
+void rollup_init(RollupState &s);
+bool rollup_valid(const RollupState &s);
+
+// Bucket start containing t
+uint32_t rollup_bucketStart(RollupKind kind, uint32_t t);
+uint32_t rollup_periodS(RollupKind kind);
+
+// Fold one record into its hour and day. Returns false if it could not be
+// placed at all (no time, or both buckets already taken).
+bool rollup_add(RollupState &s, const RollupSample &r);
+
+// Copy out closed (ending at or before nowS), not yet taken buckets, oldest
+// first; they will not be returned again. Returns the number copied. Take
+// before adding a wake's record, so a long gap cannot recycle a closed
+// bucket's slot before it was reported.
+size_t rollup_take(RollupState &s, RollupKind kind, uint32_t nowS, RollupBucket *out, size_t max);
+
+// Weight change over the bucket (last - first); false without two weights
+bool rollup_weightDelta(const RollupBucket &b, int32_t &delta);
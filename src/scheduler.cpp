@@ -0,0 +1,61 @@
+#include "scheduler.h"
+
+#include <string.h>
+
+// Wrap-safe "a is before b" on the 32-bit seconds clock
+static bool before(uint32_t a, uint32_t b) {
+  return (int32_t)(a - b) < 0;
+}
+
+void sched_begin(SchedState &s, const uint32_t *periodsS, uint8_t count, uint32_t nowS) {
+  if (count > SCHED_MAX_TASKS) count = SCHED_MAX_TASKS;
+  bool valid = s.magic == SCHED_MAGIC && s.count == count;
+  for (uint8_t i = 0; valid && i < count; ++i) valid = s.periodS[i] == periodsS[i] && periodsS[i] > 0;
+  if (!valid) {
+    memset(&s, 0, sizeof(s));
+    s.magic = SCHED_MAGIC;
+    s.count = count;
+    for (uint8_t i = 0; i < count; ++i) {
+      s.periodS[i] = periodsS[i] ? periodsS[i] : 1;
+      s.dueS[i] = nowS;
+    }
+    return;
+  }
+  for (uint8_t i = 0; i < count; ++i) {
+    if (before(nowS + s.periodS[i], s.dueS[i])) s.dueS[i] = nowS;
+  }
+}
+
+uint32_t sched_dueMask(const SchedState &s, uint32_t nowS, uint32_t toleranceS) {
+  uint32_t mask = 0;
+  for (uint8_t i = 0; i < s.count; ++i) {
+    if (!before(nowS + toleranceS, s.dueS[i])) mask |= 1UL << i;
+  }
+  return mask;
+}
+
+void sched_markRun(SchedState &s, uint32_t mask, uint32_t nowS) {
+  for (uint8_t i = 0; i < s.count; ++i) {
+    if (!(mask & (1UL << i))) continue;
+    s.dueS[i] += s.periodS[i];
+    if (!before(nowS, s.dueS[i])) {
+      // Late by one or more periods: skip to the next slot in phase
+      const uint32_t behind = nowS - s.dueS[i];
+      s.dueS[i] += (behind / s.periodS[i] + 1) * s.periodS[i];
+    }
+  }
+}
+
+uint32_t sched_nextDueS(const SchedState &s) {
+  uint32_t next = s.count ? s.dueS[0] : 0;
+  for (uint8_t i = 1; i < s.count; ++i) {
+    if (before(s.dueS[i], next)) next = s.dueS[i];
+  }
+  return next;
+}
+
+uint32_t sched_sleepS(const SchedState &s, uint32_t nowS, uint32_t minS) {
+  const uint32_t next = sched_nextDueS(s);
+  if (!before(nowS + minS, next)) return minS;
+  return next - nowS;
+}
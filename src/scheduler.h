@@ -0,0 +1,42 @@
+// Multi-rate task scheduler for deep-sleep wakes
+// Portable (no Arduino dependencies) so schedules can be simulated on the host.
+//
+// Each task has a period and a next-due time on a monotonic seconds clock
+// that keeps running through deep sleep (the RTC counter). A wake runs every
+// task due within the tolerance window, so tasks that fall close together
+// share one wake instead of waking the device twice; the next timer wakeup is
+// the earliest remaining deadline. Due times advance in whole periods from
+// their own phase, so running a task a little early or late does not make
+// the schedule drift.
+#pragma once
+
+#include <stdint.h>
+
+#define SCHED_MAGIC     0x53434844UL  // "SCHD"
+#define SCHED_MAX_TASKS 8
+#define SCHED_ALL(count) ((uint32_t)((1UL << (count)) - 1))
+
+// Kept in RTC memory across deep sleep
+struct SchedState {
+  uint32_t magic;
+  uint8_t count;
+  uint32_t periodS[SCHED_MAX_TASKS];
+  uint32_t dueS[SCHED_MAX_TASKS];
+};
+
+// Call once per wake. (Re)initializes with every task due now when the state
+// is invalid or the configured periods changed, and pulls in due times that
+// lie more than a period ahead (the clock restarted).
+void sched_begin(SchedState &s, const uint32_t *periodsS, uint8_t count, uint32_t nowS);
+
+// Bitmask of tasks due at or before nowS + toleranceS
+uint32_t sched_dueMask(const SchedState &s, uint32_t nowS, uint32_t toleranceS);
+
+// Advance the given tasks past nowS by whole periods (missed runs are skipped)
+void sched_markRun(SchedState &s, uint32_t mask, uint32_t nowS);
+
+// Earliest deadline over all tasks
+uint32_t sched_nextDueS(const SchedState &s);
+
+// Seconds to sleep from nowS until the next deadline (at least minS)
+uint32_t sched_sleepS(const SchedState &s, uint32_t nowS, uint32_t minS);
@@ -4,9 +4,12 @@
 #include <DallasTemperature.h>
 #include <HX711.h>
 #include <Preferences.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 
 #include "buttons.h"
 #include "display.h"
+#include "log.h"
 
 static OneWire oneWire(DS18B20_PIN);
 static DallasTemperature ds18b20(&oneWire);
@@ -19,6 +22,16 @@ struct HX711Cal {
   float scale;
 };
 static HX711Cal g_hxCal = {false, 0, 0.0f};
+static bool g_sensorsInited = false;
+
+// Activity stream task: on the core not used by loop()/capture, lowest priority
+#define HX711_STREAM_CORE  0
+#define HX711_STREAM_PRIO  1
+#define HX711_STREAM_STACK 3072
+
+static ActivityState *s_stream = nullptr;
+static volatile bool s_streamRun = false;
+static SemaphoreHandle_t s_streamDone = nullptr;
 
 // Optional compile-time calibration
 #ifndef HX711_CAL_WEIGHT
@@ -52,6 +65,8 @@ static void saveHXCal(long offset, float scale) {
 }
 
 void sensors_init() {
+  if (g_sensorsInited) return;
+  g_sensorsInited = true;
   // Init HX711 so readiness checks work
   hx711.begin(HX711_DOUT_PIN, HX711_SCK_PIN);
   loadHXCal();
@@ -76,7 +91,23 @@ bool sensors_readDS18B20C(float &outC) {
   return true;
 }
 
+// Average of up to "samples" conversions, each waited for with a timeout (the
+// library's read_average() spins forever if DOUT never goes low)
+static bool readAverageBounded(int samples, long &outAvg) {
+  long long sum = 0;
+  int n = 0;
+  for (int i = 0; i < samples; ++i) {
+    if (!hx711.wait_ready_timeout(HX711_SAMPLE_TIMEOUT_MS)) break;
+    sum += hx711.read();
+    n++;
+  }
+  if (!n) return false;
+  outAvg = (long)(sum / n);
+  return true;
+}
+
 bool sensors_readHX711(long &outRaw, bool &hasUnits, float &outUnits, int samples) {
+  sensors_init();
   if (!hx711.is_ready()) {
     // try to initialize and wait briefly
     hx711.begin(HX711_DOUT_PIN, HX711_SCK_PIN);
@@ -84,17 +115,16 @@ bool sensors_readHX711(long &outRaw, bool &hasUnits, float &outUnits, int sample
   if (!hx711.wait_ready_timeout(1000)) {
     return false;
   }
-  outRaw = hx711.read_average(samples);
+  if (!readAverageBounded(samples, outRaw)) {
+    return false;
+  }
+  // Units from the same conversions (as get_units(): (raw - offset) / scale)
   if (g_hxCal.loaded) {
-    hx711.set_scale(g_hxCal.scale);
-    hx711.set_offset(g_hxCal.offset);
-    outUnits = hx711.get_units(samples);
+    outUnits = (float)(outRaw - g_hxCal.offset) / g_hxCal.scale;
     hasUnits = true;
   } else {
 #if defined(HX711_SCALE) && defined(HX711_OFFSET)
-    hx711.set_scale((float)HX711_SCALE);
-    hx711.set_offset((long)HX711_OFFSET);
-    outUnits = hx711.get_units(samples);
+    outUnits = (float)(outRaw - (long)HX711_OFFSET) / (float)HX711_SCALE;
     hasUnits = true;
 #else
     hasUnits = false;
@@ -104,6 +134,7 @@ bool sensors_readHX711(long &outRaw, bool &hasUnits, float &outUnits, int sample
 }
 
 bool sensors_runHX711Calibration() {
+  sensors_init();
   display_fillScreen(ST77XX_BLACK);
   display_printAt("HiveSync", TFT_LINE_1, ST77XX_YELLOW);
   display_printAt("Calibrate HX711", TFT_LINE_2, ST77XX_WHITE);
@@ -153,7 +184,7 @@ bool sensors_runHX711Calibration() {
       display_fillRect(0, TFT_LINE_2 - 20, 240, 32, ST77XX_BLACK);
       snprintf(wline, sizeof(wline), "Weight: %.0f %s", selWeight, HX711_UNITS_LABEL);
       display_printAt(String(wline), TFT_LINE_2, ST77XX_WHITE);
-      Serial.printf("Calibration weight set: %.0f %s\n", selWeight, HX711_UNITS_LABEL);
+      LOG_I("Calibration weight set: %.0f %s", selWeight, HX711_UNITS_LABEL);
       buttons_waitRelease(SEL_BTN_PIN, SEL_BTN_ACTIVE_LEVEL);
       delay(50);
     }
@@ -194,7 +225,67 @@ bool sensors_runHX711Calibration() {
   return true;
 }
 
+static void streamTask(void *) {
+  int settle = HX711_STREAM_SETTLE;
+  while (s_streamRun) {
+    // Poll DOUT with delay(1): the library default of 0 only yields to equal
+    // priority, which would starve core 0's idle task and trip the watchdog
+    if (!hx711.wait_ready_timeout(HX711_SAMPLE_TIMEOUT_MS, 1)) {
+      activity_gap(*s_stream);
+      continue;
+    }
+    const long raw = hx711.read();
+    if (settle > 0) {
+      settle--;
+      continue;
+    }
+    activity_add(*s_stream, (int32_t)raw, millis());
+  }
+  xSemaphoreGive(s_streamDone);
+  vTaskDelete(nullptr);
+}
+
+bool sensors_beginHX711Stream(ActivityState &state) {
+  sensors_init();
+  if (s_streamRun || !hx711.wait_ready_timeout(1000, 1)) return false;
+  if (!s_streamDone) s_streamDone = xSemaphoreCreateBinary();
+  if (!s_streamDone) return false;
+  activity_begin(state);
+  s_stream = &state;
+#ifdef HX711_RATE_PIN
+  pinMode(HX711_RATE_PIN, OUTPUT);
+  digitalWrite(HX711_RATE_PIN, HIGH);
+#endif
+  s_streamRun = true;
+  if (xTaskCreatePinnedToCore(streamTask, "hx_stream", HX711_STREAM_STACK, nullptr, HX711_STREAM_PRIO, nullptr,
+                              HX711_STREAM_CORE) != pdPASS) {
+    s_streamRun = false;
+#ifdef HX711_RATE_PIN
+    digitalWrite(HX711_RATE_PIN, LOW);
+#endif
+    return false;
+  }
+  return true;
+}
+
+void sensors_endHX711Stream() {
+  if (!s_streamRun) return;
+  s_streamRun = false;
+  // The task finishes its current conversion wait first
+  xSemaphoreTake(s_streamDone, pdMS_TO_TICKS(HX711_SAMPLE_TIMEOUT_MS + 100));
+#ifdef HX711_RATE_PIN
+  digitalWrite(HX711_RATE_PIN, LOW);  // back to 10 SPS for the averaged reads
+#endif
+}
+
 void sensors_powerDown() {
-  hx711.power_down();
+  if (g_sensorsInited) {
+    hx711.power_down();
+    return;
+  }
+  // HX711 untouched this wake: no begin() or calibration load, just hold
+  // PD_SCK high (> 60 us powers the chip down)
+  pinMode(HX711_SCK_PIN, OUTPUT);
+  digitalWrite(HX711_SCK_PIN, HIGH);
 }
 
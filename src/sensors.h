@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include "pins_config.h"
+#include "weight_activity.h"
 
 // DS18B20 and HX711 pins are centralized in pins_config.h
 
@@ -11,7 +12,18 @@
 #define HX711_UNITS_LABEL "lbs"
 #endif
 
-// Initialization (pins, loading calibration)
+// Longest wait for one HX711 conversion (10 SPS mode converts every 100 ms)
+#ifndef HX711_SAMPLE_TIMEOUT_MS
+#define HX711_SAMPLE_TIMEOUT_MS 200
+#endif
+
+// Activity streaming: HX711 RATE pin driven high (80 SPS) while streaming, if
+// wired to a GPIO (pins_config.h); otherwise the stream runs at the strapped rate
+#ifndef HX711_STREAM_SETTLE
+#define HX711_STREAM_SETTLE 4  // conversions discarded after switching rate
+#endif
+
+// Initialization (pins, loading calibration); idempotent, and done on first HX711 use
 void sensors_init();
 
 // DS18B20
@@ -20,4 +32,10 @@ bool sensors_readDS18B20C(float &outC);
 // HX711
 bool sensors_readHX711(long &outRaw, bool &hasUnits, float &outUnits, int samples = 10);
 bool sensors_runHX711Calibration();
+
+// Stream HX711 conversions into state from a task on core 0 (the audio
+// capture runs on core 1) until sensors_endHX711Stream(). Fails if the HX711
+// does not answer.
+bool sensors_beginHX711Stream(ActivityState &state);
+void sensors_endHX711Stream();
 void sensors_powerDown();
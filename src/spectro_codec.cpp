@@ -0,0 +1,228 @@
+#include "spectro_codec.h"
+
+#include <math.h>
+#include <string.h>
+
+// Adaptive Rice parameters
+#define RICE_ESCAPE_Q   12  // unary prefix length that signals a raw 8-bit residual
+#define RICE_MAX_K      7
+#define RICE_RESCALE_N  32  // halve the context when this many symbols were seen
+
+static uint8_t riceK(uint32_t a, uint32_t n) {
+  uint8_t k = 0;
+  while (k < RICE_MAX_K && (n << k) < a) ++k;
+  return k;
+}
+
+static void riceUpdate(uint32_t &a, uint32_t &n, uint32_t v) {
+  a += v;
+  n++;
+  if (n >= RICE_RESCALE_N) {
+    a >>= 1;
+    n >>= 1;
+  }
+}
+
+static uint8_t zigzag8(uint8_t code, uint8_t prev) {
+  const int8_t d = (int8_t)(uint8_t)(code - prev);
+  return (uint8_t)(((uint8_t)d << 1) ^ (uint8_t)(d >> 7));
+}
+
+static uint8_t unzigzag8(uint8_t v, uint8_t prev) {
+  const uint8_t d = (uint8_t)((v >> 1) ^ (uint8_t)(-(int)(v & 1)));
+  return (uint8_t)(prev + d);
+}
+
+static void put16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static uint16_t get16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+uint8_t spectro_quantize(float magnitude, const SpectroInfo &info) {
+  if (!(magnitude > 0.0f)) return 0;
+  const float db = 20.0f * log10f(magnitude);
+  const float step = (float)info.dbStepX100 / 100.0f;
+  const float code = (db - (float)info.dbFloorX10 / 10.0f) / (step > 0.0f ? step : 1.0f);
+  if (code <= 0.0f) return 0;
+  if (code >= 255.0f) return 255;
+  return (uint8_t)(code + 0.5f);
+}
+
+float spectro_codeToDb(uint8_t code, const SpectroInfo &info) {
+  return (float)info.dbFloorX10 / 10.0f + (float)code * (float)info.dbStepX100 / 100.0f;
+}
+
+// ---------------- Encoder ----------------
+
+bool SpectroEncoder::begin(uint8_t *buf, size_t capacity, const SpectroInfo &info) {
+  buf_ = buf;
+  cap_ = capacity;
+  info_ = info;
+  info_.columns = 0;
+  info_.truncated = false;
+  memset(prev_, 0, sizeof(prev_));
+  st_ = {};
+  st_.pos = SPECTRO_HEADER_SIZE;
+  st_.a = 4;
+  st_.n = 1;
+  if (!buf_ || cap_ <= SPECTRO_HEADER_SIZE || info_.bands == 0 || info_.bands > SPECTRO_MAX_BANDS) {
+    info_.truncated = true;
+    return false;
+  }
+  writeHeader();
+  return true;
+}
+
+bool SpectroEncoder::putBit(State &s, uint32_t bit) {
+  s.acc = (uint8_t)((s.acc << 1) | (bit & 1));
+  if (++s.nbits == 8) {
+    if (s.pos >= cap_) return false;
+    buf_[s.pos++] = s.acc;
+    s.acc = 0;
+    s.nbits = 0;
+  }
+  return true;
+}
+
+bool SpectroEncoder::putBits(State &s, uint32_t value, uint8_t count) {
+  while (count--) {
+    if (!putBit(s, (value >> count) & 1)) return false;
+  }
+  return true;
+}
+
+bool SpectroEncoder::addColumn(const uint8_t *codes) {
+  if (info_.truncated || info_.columns == 0xFFFF) {
+    info_.truncated = true;
+    return false;
+  }
+  // Work on a copy so a column that does not fit leaves the stream untouched
+  State s = st_;
+  bool ok = true;
+  for (uint8_t b = 0; ok && b < info_.bands; ++b) {
+    const uint8_t v = zigzag8(codes[b], prev_[b]);
+    const uint8_t k = riceK(s.a, s.n);
+    const uint32_t q = (uint32_t)v >> k;
+    if (q < RICE_ESCAPE_Q) {
+      for (uint32_t i = 0; ok && i < q; ++i) ok = putBit(s, 1);
+      ok = ok && putBit(s, 0) && putBits(s, v, k);
+    } else {
+      for (uint32_t i = 0; ok && i < RICE_ESCAPE_Q; ++i) ok = putBit(s, 1);
+      ok = ok && putBits(s, v, 8);
+    }
+    riceUpdate(s.a, s.n, v);
+  }
+  // Reserve room for the final partial byte
+  if (!ok || (s.nbits && s.pos >= cap_)) {
+    info_.truncated = true;
+    return false;
+  }
+  st_ = s;
+  memcpy(prev_, codes, info_.bands);
+  info_.columns++;
+  return true;
+}
+
+void SpectroEncoder::writeHeader() {
+  uint8_t *h = buf_;
+  h[0] = (uint8_t)(SPECTRO_MAGIC);
+  h[1] = (uint8_t)(SPECTRO_MAGIC >> 8);
+  h[2] = (uint8_t)(SPECTRO_MAGIC >> 16);
+  h[3] = (uint8_t)(SPECTRO_MAGIC >> 24);
+  h[4] = SPECTRO_VERSION;
+  h[5] = info_.bands;
+  put16(h + 6, info_.cellMs);
+  put16(h + 8, info_.fLowHz);
+  put16(h + 10, info_.fHighHz);
+  put16(h + 12, (uint16_t)info_.dbFloorX10);
+  h[14] = info_.dbStepX100;
+  h[15] = info_.truncated ? 1 : 0;
+  put16(h + 16, info_.columns);
+  put16(h + 18, 0);
+}
+
+size_t SpectroEncoder::finish() {
+  if (!buf_ || cap_ <= SPECTRO_HEADER_SIZE) return 0;
+  if (st_.nbits) {
+    // addColumn guaranteed space for this byte
+    buf_[st_.pos++] = (uint8_t)(st_.acc << (8 - st_.nbits));
+    st_.acc = 0;
+    st_.nbits = 0;
+  }
+  writeHeader();
+  return st_.pos;
+}
+
+// ---------------- Decoder ----------------
+
+bool SpectroDecoder::begin(const uint8_t *buf, size_t len) {
+  buf_ = buf;
+  len_ = len;
+  if (!buf_ || len_ < SPECTRO_HEADER_SIZE) return false;
+  const uint32_t magic = (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+                         ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+  if (magic != SPECTRO_MAGIC || buf[4] != SPECTRO_VERSION) return false;
+  info_.bands = buf[5];
+  info_.cellMs = get16(buf + 6);
+  info_.fLowHz = get16(buf + 8);
+  info_.fHighHz = get16(buf + 10);
+  info_.dbFloorX10 = (int16_t)get16(buf + 12);
+  info_.dbStepX100 = buf[14];
+  info_.truncated = (buf[15] & 1) != 0;
+  info_.columns = get16(buf + 16);
+  if (info_.bands == 0 || info_.bands > SPECTRO_MAX_BANDS) return false;
+  pos_ = SPECTRO_HEADER_SIZE;
+  bit_ = 0;
+  a_ = 4;
+  n_ = 1;
+  decoded_ = 0;
+  memset(prev_, 0, sizeof(prev_));
+  return true;
+}
+
+int SpectroDecoder::getBit() {
+  if (pos_ >= len_) return -1;
+  const int bit = (buf_[pos_] >> (7 - bit_)) & 1;
+  if (++bit_ == 8) {
+    bit_ = 0;
+    pos_++;
+  }
+  return bit;
+}
+
+bool SpectroDecoder::getBits(uint8_t count, uint32_t &out) {
+  out = 0;
+  while (count--) {
+    const int bit = getBit();
+    if (bit < 0) return false;
+    out = (out << 1) | (uint32_t)bit;
+  }
+  return true;
+}
+
+bool SpectroDecoder::nextColumn(uint8_t *codes) {
+  if (!buf_ || decoded_ >= info_.columns) return false;
+  for (uint8_t b = 0; b < info_.bands; ++b) {
+    const uint8_t k = riceK(a_, n_);
+    uint32_t q = 0;
+    int bit;
+    while ((bit = getBit()) == 1 && q < RICE_ESCAPE_Q) ++q;
+    uint32_t v = 0;
+    if (q >= RICE_ESCAPE_Q) {
+      // Escape: the terminating bit read above was the first raw bit
+      if (bit < 0) return false;
+      uint32_t rest = 0;
+      if (!getBits(7, rest)) return false;
+      v = ((uint32_t)bit << 7) | rest;
+    } else {
+      if (bit < 0) return false;
+      uint32_t low = 0;
+      if (!getBits(k, low)) return false;
+      v = (q << k) | low;
+    }
+    if (v > 255) return false;
+    riceUpdate(a_, n_, v);
+    codes[b] = unzigzag8((uint8_t)v, prev_[b]);
+    prev_[b] = codes[b];
+  }
+  decoded_++;
+  return true;
+}
@@ -0,0 +1,81 @@
+// Compact spectrogram stream: 8-bit log-magnitude cells, time-delta + adaptive Rice coded
+// Portable (no Arduino dependencies) so the same code decodes on the host (tools/).
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SPECTRO_MAGIC       0x47535348UL  // "HSSG" little-endian
+#define SPECTRO_VERSION     1
+#define SPECTRO_HEADER_SIZE 20
+#define SPECTRO_MAX_BANDS   64
+
+// Stream description (serialized little-endian into the first SPECTRO_HEADER_SIZE bytes)
+struct SpectroInfo {
+  uint8_t bands;      // cells per column
+  uint16_t cellMs;    // column duration
+  uint16_t fLowHz;    // lower edge of band 0
+  uint16_t fHighHz;   // upper edge of the last band
+  int16_t dbFloorX10; // dB value of code 0, in 0.1 dB
+  uint8_t dbStepX100; // dB per code step, in 0.01 dB
+  uint16_t columns;   // columns encoded
+  bool truncated;     // buffer filled before the capture ended
+};
+
+// Map a linear magnitude to an 8-bit log code (clamped)
+uint8_t spectro_quantize(float magnitude, const SpectroInfo &info);
+// Inverse: code to dB
+float spectro_codeToDb(uint8_t code, const SpectroInfo &info);
+
+// Streaming encoder writing into a caller-owned bounded buffer. Each column is
+// committed atomically: if it does not fit, the stream is marked truncated and
+// later columns are dropped.
+class SpectroEncoder {
+ public:
+  bool begin(uint8_t *buf, size_t capacity, const SpectroInfo &info);
+  bool addColumn(const uint8_t *codes);
+  // Flush trailing bits and patch the header; returns total bytes used.
+  size_t finish();
+  const SpectroInfo &info() const { return info_; }
+
+ private:
+  struct State {
+    size_t pos;    // byte position of the next write
+    uint8_t acc;   // partially filled byte
+    uint8_t nbits; // bits used in acc
+    uint32_t a;    // adaptive Rice context: sum of mapped residuals
+    uint32_t n;    // adaptive Rice context: count
+  };
+  bool putBit(State &s, uint32_t bit);
+  bool putBits(State &s, uint32_t value, uint8_t count);
+  void writeHeader();
+
+  uint8_t *buf_ = nullptr;
+  size_t cap_ = 0;
+  SpectroInfo info_ = {};
+  State st_ = {};
+  uint8_t prev_[SPECTRO_MAX_BANDS] = {};
+};
+
+// Decoder for a complete stream produced by SpectroEncoder
+class SpectroDecoder {
+ public:
+  bool begin(const uint8_t *buf, size_t len);
+  const SpectroInfo &info() const { return info_; }
+  // Decode the next column into codes[info().bands]; false when done or corrupt.
+  bool nextColumn(uint8_t *codes);
+
+ private:
+  int getBit();
+  bool getBits(uint8_t count, uint32_t &out);
+
+  const uint8_t *buf_ = nullptr;
+  size_t len_ = 0;
+  size_t pos_ = 0;
+  uint8_t bit_ = 0;
+  uint32_t a_ = 0;
+  uint32_t n_ = 0;
+  uint16_t decoded_ = 0;
+  SpectroInfo info_ = {};
+  uint8_t prev_[SPECTRO_MAX_BANDS] = {};
+};
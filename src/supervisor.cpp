@@ -0,0 +1,137 @@
+#include "supervisor.h"
+
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "esp_task_wdt.h"
+#include "log.h"
+
+// RTC_DATA_ATTR is reloaded on watchdog/panic resets; these counters must
+// survive them as well as deep sleep (validated by magic after power-on)
+RTC_NOINIT_ATTR static WakeStats s_stats;
+static WakeStageSpec s_specs[WAKE_STAGES];
+static WakeBudget s_budget;
+static bool s_begun = false;
+static bool s_wdtSubscribed = false;
+static bool s_radioOn = false;
+
+static const char *const kStageNames[WAKE_STAGES] = {"boot", "wifi", "sntp", "temp", "weight", "audio", "uplink"};
+
+static bool watchdogReset(esp_reset_reason_t reason) {
+  return reason == ESP_RST_TASK_WDT || reason == ESP_RST_INT_WDT || reason == ESP_RST_WDT;
+}
+
+bool supervisor_init() {
+  const bool wdt = watchdogReset(esp_reset_reason());
+  const uint8_t hung = s_stats.magic == WAKE_STATS_MAGIC ? s_stats.stage : WAKE_STAGES;
+  budget_statsBegin(s_stats, wdt);
+  if (wdt) {
+    LOG_W("Watchdog reset during %s stage (%u so far)", hung < WAKE_STAGES ? kStageNames[hung] : "unknown",
+          s_stats.watchdogResets);
+  }
+  return wdt;
+}
+
+static void watchdogBegin() {
+  if (s_wdtSubscribed) return;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+  esp_task_wdt_config_t cfg = {};
+  cfg.timeout_ms = WAKE_WDT_S * 1000;
+  cfg.idle_core_mask = 1 << 0;  // keep the core's default idle-task check
+  cfg.trigger_panic = true;
+  if (esp_task_wdt_reconfigure(&cfg) == ESP_ERR_INVALID_STATE) esp_task_wdt_init(&cfg);
+#else
+  esp_task_wdt_init(WAKE_WDT_S, true);  // reconfigures when already running
+#endif
+  s_wdtSubscribed = esp_task_wdt_add(nullptr) == ESP_OK;
+  if (!s_wdtSubscribed) LOG_W("Task watchdog unavailable");
+}
+
+void supervisor_begin(bool headless, bool unlimited) {
+  // The radio is charged apart from the stages (supervisor_radio)
+  s_specs[WAKE_BOOT] = {0, WAKE_CPU_MA};
+  s_specs[WAKE_WIFI] = {(uint32_t)(headless ? WAKE_WIFI_MS : WAKE_UI_WIFI_MS), WAKE_CPU_MA};
+  s_specs[WAKE_SNTP] = {WAKE_SNTP_MS, WAKE_CPU_MA};
+  s_specs[WAKE_TEMP] = {WAKE_TEMP_MS, WAKE_CPU_MA};
+  s_specs[WAKE_WEIGHT] = {WAKE_WEIGHT_MS, WAKE_CPU_MA};
+  s_specs[WAKE_AUDIO] = {WAKE_AUDIO_MS, WAKE_CPU_MA};
+  s_specs[WAKE_UPLINK] = {WAKE_UPLINK_MS, WAKE_CPU_MA};
+  // Button/power-on wakes are interactive: time limit only
+  const uint32_t limitMs = unlimited ? 0 : (headless ? WAKE_LIMIT_MS : WAKE_UI_LIMIT_MS);
+  const uint32_t chargeMAs = unlimited || !headless ? 0 : WAKE_CHARGE_MAS;
+  const uint32_t now = millis();
+  budget_begin(s_budget, s_stats, s_specs, limitMs, chargeMAs, now);
+  if (s_radioOn) budget_radio(s_budget, WAKE_RADIO_MA, now);  // gateway: stays on between cycles
+  s_begun = true;
+  watchdogBegin();
+}
+
+void supervisor_feed() {
+  if (s_wdtSubscribed) esp_task_wdt_reset();
+}
+
+void supervisor_radio(bool on) {
+  s_radioOn = on;
+  if (s_begun) budget_radio(s_budget, on ? WAKE_RADIO_MA : 0, millis());
+}
+
+bool supervisor_ok() {
+  supervisor_feed();
+  if (!s_begun) return true;
+  const bool failedBefore = s_budget.stageFailed;
+  const uint32_t now = millis();
+  if (budget_ok(s_budget, now)) return true;
+  if (!failedBefore) {
+    const uint32_t deadline = s_specs[s_budget.stage].deadlineMs;
+    const bool late = deadline && now - s_budget.stageStartMs >= deadline;
+    LOG_W("%s stage abandoned: %s", kStageNames[s_budget.stage], late ? "deadline passed" : "wake budget spent");
+  }
+  return false;
+}
+
+void supervisor_stage(WakeStage stage) {
+  // Closing poll: a stage that finished late still counts as an overrun
+  supervisor_ok();
+  if (s_begun) budget_enter(s_budget, stage, millis());
+}
+
+bool supervisor_canStart(WakeStage stage, uint32_t minMs) {
+  supervisor_ok();
+  if (!s_begun) return true;
+  if (budget_canStart(s_budget, stage, minMs, millis())) return true;
+  LOG_W("%s stage skipped: %lu ms of budget left", kStageNames[stage],
+        (unsigned long)budget_remainingMs(s_budget, millis()));
+  return false;
+}
+
+uint32_t supervisor_remainingMs() {
+  return s_begun ? budget_remainingMs(s_budget, millis()) : UINT32_MAX;
+}
+
+uint8_t supervisor_faults() {
+  return s_begun ? s_budget.faults : s_stats.pendingFaults;
+}
+
+WakeStage supervisor_repeatedHang() {
+  return budget_repeatedHang(s_stats);
+}
+
+uint8_t supervisor_overruns() {
+  uint32_t n = s_stats.budgetCuts + s_stats.skipped;
+  for (uint8_t i = 0; i < WAKE_STAGES; ++i) n += s_stats.overruns[i];
+  return n > 255 ? 255 : (uint8_t)n;
+}
+
+void supervisor_end() {
+  if (!s_begun) return;
+  supervisor_ok();
+  const uint32_t now = millis();
+  budget_end(s_budget, now);
+  s_begun = false;
+  LOG_I("Wake: %lu ms, ~%.0f mAs, faults 0x%02x", (unsigned long)(now - s_budget.startMs),
+        s_budget.usedMAs, s_budget.faults);
+  LOG_I("Overruns: wifi %u sntp %u temp %u weight %u audio %u uplink %u", s_stats.overruns[WAKE_WIFI],
+        s_stats.overruns[WAKE_SNTP], s_stats.overruns[WAKE_TEMP], s_stats.overruns[WAKE_WEIGHT],
+        s_stats.overruns[WAKE_AUDIO], s_stats.overruns[WAKE_UPLINK]);
+  LOG_I("Budget cuts: %u, stages skipped: %u, watchdog resets: %u", s_stats.budgetCuts, s_stats.skipped,
+        s_stats.watchdogResets);
+}
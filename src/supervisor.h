@@ -0,0 +1,87 @@
+// Per-wake supervisor: stage deadlines, wake time/charge budget and the task
+// watchdog (budget logic in wake_budget.h)
+#pragma once
+
+#include <Arduino.h>
+#include "wake_budget.h"
+
+// Whole-wake limits. Headless (timer) wakes get the tight budget; power-on and
+// button wakes leave room for BLE provisioning by hand.
+#ifndef WAKE_LIMIT_MS
+#define WAKE_LIMIT_MS (90UL * 1000UL)
+#endif
+#ifndef WAKE_UI_LIMIT_MS
+#define WAKE_UI_LIMIT_MS (10UL * 60UL * 1000UL)
+#endif
+#ifndef WAKE_CHARGE_MAS
+#define WAKE_CHARGE_MAS 6000UL  // ~1.7 mAh per wake
+#endif
+
+// Stage deadlines
+#ifndef WAKE_WIFI_MS
+#define WAKE_WIFI_MS (20UL * 1000UL)
+#endif
+#ifndef WAKE_UI_WIFI_MS
+#define WAKE_UI_WIFI_MS (5UL * 60UL * 1000UL)
+#endif
+#ifndef WAKE_SNTP_MS
+#define WAKE_SNTP_MS 5000UL
+#endif
+#ifndef WAKE_TEMP_MS
+#define WAKE_TEMP_MS 3000UL
+#endif
+#ifndef WAKE_WEIGHT_MS
+#define WAKE_WEIGHT_MS 5000UL
+#endif
+#ifndef WAKE_AUDIO_MS
+#define WAKE_AUDIO_MS (65UL * 1000UL)
+#endif
+#ifndef WAKE_UPLINK_MS
+#define WAKE_UPLINK_MS (10UL * 1000UL)
+#endif
+
+// Assumed average draw (mA) for the charge estimate: every stage runs at
+// WAKE_CPU_MA, plus WAKE_RADIO_MA for as long as Wi-Fi/BLE/ESP-NOW is on
+#ifndef WAKE_CPU_MA
+#define WAKE_CPU_MA 45
+#endif
+#ifndef WAKE_RADIO_MA
+#define WAKE_RADIO_MA 85
+#endif
+
+// Task watchdog on the loop task: catches calls that block despite deadlines
+#ifndef WAKE_WDT_S
+#define WAKE_WDT_S 20
+#endif
+
+// Call early in setup(): restores counters, notes a watchdog reset.
+// Returns true if the previous wake was ended by the watchdog.
+bool supervisor_init();
+
+// Start the wake (or a gateway cycle) budget and subscribe the loop task to
+// the watchdog. Gateways pass unlimited = true: only stage deadlines apply.
+void supervisor_begin(bool headless, bool unlimited = false);
+
+// Enter a stage / poll it (both feed the watchdog)
+void supervisor_stage(WakeStage stage);
+bool supervisor_ok();
+bool supervisor_canStart(WakeStage stage, uint32_t minMs);
+uint32_t supervisor_remainingMs();
+
+// Keep the watchdog quiet during long, progressing work
+void supervisor_feed();
+
+// The radio was switched on/off: charged at WAKE_RADIO_MA while on, across
+// stages and gateway cycles
+void supervisor_radio(bool on);
+
+// Stages abandoned this wake (WAKE_FAULT bits) and total overruns since power-on
+uint8_t supervisor_faults();
+uint8_t supervisor_overruns();
+
+// Stage that hung the last two wakes in a row, else WAKE_STAGES: its work
+// should wait for its next period instead of resetting the chip again
+WakeStage supervisor_repeatedHang();
+
+// Close the wake and log time, estimated charge and counters
+void supervisor_end();
@@ -0,0 +1,61 @@
+#include "time_model.h"
+
+#include <math.h>
+#include <string.h>
+
+void tm_init(TimeModel &m) {
+  memset(&m, 0, sizeof(m));
+  m.driftUncPpm = TIME_MODEL_INITIAL_UNC_PPM;
+}
+
+bool tm_valid(const TimeModel &m) {
+  return m.magic == TIME_MODEL_MAGIC;
+}
+
+int64_t tm_nowUs(const TimeModel &m, uint64_t rtcUs) {
+  if (!tm_valid(m)) return 0;
+  const double elapsed = (double)(int64_t)(rtcUs - m.anchorRtcUs);
+  return m.anchorEpochUs + (int64_t)llround(elapsed * (1.0 - (double)m.driftPpm * 1e-6));
+}
+
+uint32_t tm_errorBoundUs(const TimeModel &m, uint64_t rtcUs) {
+  if (!tm_valid(m)) return UINT32_MAX;
+  const double elapsed = (double)(rtcUs - m.anchorRtcUs);
+  const double bound = (double)m.anchorErrorUs + elapsed * (double)m.driftUncPpm * 1e-6;
+  return bound >= (double)UINT32_MAX ? UINT32_MAX : (uint32_t)bound;
+}
+
+bool tm_needsSync(const TimeModel &m, uint64_t rtcUs, uint32_t thresholdUs) {
+  return !tm_valid(m) || tm_errorBoundUs(m, rtcUs) > thresholdUs;
+}
+
+void tm_sync(TimeModel &m, int64_t epochUs, uint64_t rtcUs, uint32_t accuracyUs) {
+  bool rebase = !tm_valid(m) || rtcUs <= m.baseRtcUs;
+  if (!rebase && (rtcUs - m.baseRtcUs) >= TIME_MODEL_MIN_LEARN_US) {
+    // Rate actually observed over the baseline vs. what the model assumed
+    const uint64_t rtcElapsed = rtcUs - m.baseRtcUs;
+    const double trueElapsed = (double)(epochUs - m.baseEpochUs);
+    const float measuredPpm = (float)((1.0 - trueElapsed / (double)rtcElapsed) * 1e6);
+    const float residual = measuredPpm - m.driftPpm;
+    // First measurement replaces the prior; later ones are smoothed
+    m.driftPpm += (m.learned == 0 ? 1.0f : 0.5f) * residual;
+    // Uncertainty covers how far the rate wandered plus sync jitter over the
+    // baseline; it decays gradually so one calm interval does not undercut it
+    const float jitterPpm = (float)((double)(accuracyUs + m.baseErrorUs) / (double)rtcElapsed * 1e6);
+    float unc = 3.0f * fabsf(residual) + jitterPpm;
+    if (m.learned && unc < 0.85f * m.driftUncPpm) unc = 0.85f * m.driftUncPpm;
+    m.driftUncPpm = unc < TIME_MODEL_MIN_UNC_PPM ? TIME_MODEL_MIN_UNC_PPM : unc;
+    if (m.learned < UINT16_MAX) m.learned++;
+    rebase = true;
+  }
+  if (rebase) {
+    m.baseEpochUs = epochUs;
+    m.baseRtcUs = rtcUs;
+    m.baseErrorUs = accuracyUs;
+  }
+  m.magic = TIME_MODEL_MAGIC;
+  m.anchorEpochUs = epochUs;
+  m.anchorRtcUs = rtcUs;
+  m.anchorErrorUs = accuracyUs;
+  if (m.syncs < UINT16_MAX) m.syncs++;
+}
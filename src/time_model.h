@@ -0,0 +1,51 @@
+// Wall-clock model over a free-running RTC counter with learned drift
+// Portable (no Arduino dependencies) so it can be simulated on the host.
+#pragma once
+
+#include <stdint.h>
+
+#define TIME_MODEL_MAGIC 0x54494D45UL  // "TIME"
+
+// Drift uncertainty assumed before the first drift measurement, and its floor
+#ifndef TIME_MODEL_INITIAL_UNC_PPM
+#define TIME_MODEL_INITIAL_UNC_PPM 500.0f
+#endif
+#ifndef TIME_MODEL_MIN_UNC_PPM
+#define TIME_MODEL_MIN_UNC_PPM 5.0f
+#endif
+// Drift is measured over at least this much RTC time; closer syncs only
+// re-anchor and keep extending the measurement baseline
+#ifndef TIME_MODEL_MIN_LEARN_US
+#define TIME_MODEL_MIN_LEARN_US (2ULL * 60ULL * 60ULL * 1000000ULL)
+#endif
+
+// Kept in RTC memory across deep sleep. The RTC counter runs through sleep, so
+// the elapsed count since the last sync is the measured sleep+wake time; it is
+// corrected by the learned drift: true = rtc * (1 - driftPpm / 1e6).
+struct TimeModel {
+  uint32_t magic;
+  int64_t anchorEpochUs;    // wall clock (Unix, us) at the last sync
+  uint64_t anchorRtcUs;     // RTC counter at the last sync
+  float driftPpm;           // learned RTC rate error (positive: RTC runs fast)
+  float driftUncPpm;        // uncertainty of driftPpm
+  uint32_t anchorErrorUs;   // accuracy of the last sync
+  int64_t baseEpochUs;      // start of the current drift measurement baseline
+  uint64_t baseRtcUs;
+  uint32_t baseErrorUs;
+  uint16_t syncs;           // syncs since power-up
+  uint16_t learned;         // syncs that updated the drift estimate
+};
+
+void tm_init(TimeModel &m);
+bool tm_valid(const TimeModel &m);
+
+// Estimated wall clock and its error bound at RTC counter value rtcUs
+int64_t tm_nowUs(const TimeModel &m, uint64_t rtcUs);
+uint32_t tm_errorBoundUs(const TimeModel &m, uint64_t rtcUs);
+
+// True when no time is known or the error bound exceeds thresholdUs
+bool tm_needsSync(const TimeModel &m, uint64_t rtcUs, uint32_t thresholdUs);
+
+// Record a real time reference (e.g. SNTP) observed at rtcUs, learn drift
+// from the elapsed interval and re-anchor.
+void tm_sync(TimeModel &m, int64_t epochUs, uint64_t rtcUs, uint32_t accuracyUs);
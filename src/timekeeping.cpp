@@ -0,0 +1,84 @@
+#include "timekeeping.h"
+
+#include <sys/time.h>
+#include "esp_sntp.h"
+#include "esp_system.h"
+#include "esp_private/esp_clk.h"
+#include "log.h"
+
+// SNTP round-trip uncertainty assumed for a completed sync
+#define SNTP_ACCURACY_US 50000
+
+// RTC_NOINIT: kept across watchdog resets as well as deep sleep
+RTC_NOINIT_ATTR static TimeModel g_timeModel;
+
+// RTC counter in microseconds; keeps running through deep sleep
+static uint64_t rtcNowUs() {
+  return esp_clk_rtc_time();
+}
+
+void timekeeping_init() {
+  // The RTC counter restarts with the RTC domain (power-on, brownout); RTC
+  // memory may survive a short one, but the model no longer matches the counter
+  const esp_reset_reason_t reason = esp_reset_reason();
+  const bool counterReset = reason == ESP_RST_POWERON || reason == ESP_RST_BROWNOUT || reason == ESP_RST_UNKNOWN;
+  if (!tm_valid(g_timeModel) || counterReset || rtcNowUs() < g_timeModel.anchorRtcUs) {
+    // Nothing known yet
+    tm_init(g_timeModel);
+    return;
+  }
+  const int64_t now = tm_nowUs(g_timeModel, rtcNowUs());
+  struct timeval tv;
+  tv.tv_sec = (time_t)(now / 1000000LL);
+  tv.tv_usec = (suseconds_t)(now % 1000000LL);
+  settimeofday(&tv, nullptr);
+}
+
+bool timekeeping_valid() {
+  return tm_valid(g_timeModel);
+}
+
+uint32_t timekeeping_nowUnix() {
+  if (!tm_valid(g_timeModel)) return 0;
+  return (uint32_t)(tm_nowUs(g_timeModel, rtcNowUs()) / 1000000LL);
+}
+
+uint32_t timekeeping_rtcSeconds() {
+  return (uint32_t)(rtcNowUs() / 1000000ULL);
+}
+
+uint32_t timekeeping_errorMs() {
+  const uint32_t us = tm_errorBoundUs(g_timeModel, rtcNowUs());
+  return us == UINT32_MAX ? UINT32_MAX : us / 1000;
+}
+
+bool timekeeping_needsSync() {
+  return tm_needsSync(g_timeModel, rtcNowUs(), (uint32_t)TIME_SYNC_THRESHOLD_MS * 1000UL);
+}
+
+bool timekeeping_syncSntp(uint32_t timeoutMs) {
+  const uint32_t start = millis();
+  sntp_set_sync_status(SNTP_SYNC_STATUS_RESET);
+  configTime(0, 0, TIME_NTP_SERVER);
+  while (sntp_get_sync_status() != SNTP_SYNC_STATUS_COMPLETED) {
+    if ((millis() - start) >= timeoutMs) {
+      LOG_W("SNTP sync timed out");
+      return false;
+    }
+    delay(20);
+  }
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  const uint64_t rtc = rtcNowUs();
+  const int64_t epochUs = (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+  const int64_t predicted = tm_nowUs(g_timeModel, rtc);
+  const bool hadTime = tm_valid(g_timeModel);
+  tm_sync(g_timeModel, epochUs, rtc, SNTP_ACCURACY_US);
+  if (hadTime) {
+    LOG_I("SNTP sync: model was off by %lld ms; drift %.1f ppm (+/- %.1f)",
+          (long long)((predicted - epochUs) / 1000), g_timeModel.driftPpm, g_timeModel.driftUncPpm);
+  } else {
+    LOG_I("SNTP sync: clock set");
+  }
+  return true;
+}
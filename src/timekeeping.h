@@ -0,0 +1,32 @@
+// Network-free timekeeping across deep sleep (RTC counter + learned drift, see time_model.h)
+#pragma once
+
+#include <Arduino.h>
+#include "time_model.h"
+
+// Request an SNTP sync once the estimated error bound exceeds this
+#ifndef TIME_SYNC_THRESHOLD_MS
+#define TIME_SYNC_THRESHOLD_MS 2000
+#endif
+#ifndef TIME_SYNC_TIMEOUT_MS
+#define TIME_SYNC_TIMEOUT_MS 3000
+#endif
+#ifndef TIME_NTP_SERVER
+#define TIME_NTP_SERVER "pool.ntp.org"
+#endif
+
+// Call early on every boot: restores the model from RTC memory and sets the
+// system clock (time()/gettimeofday) from it if valid
+void timekeeping_init();
+
+// Model state
+bool timekeeping_valid();
+uint32_t timekeeping_nowUnix();   // 0 if unknown
+uint32_t timekeeping_errorMs();   // UINT32_MAX if unknown
+bool timekeeping_needsSync();
+
+// Monotonic seconds on the RTC counter: runs through deep sleep, restarts at power-on
+uint32_t timekeeping_rtcSeconds();
+
+// Blocking SNTP sync (requires network); updates drift. Returns false on timeout.
+bool timekeeping_syncSntp(uint32_t timeoutMs = TIME_SYNC_TIMEOUT_MS);
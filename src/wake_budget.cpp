@@ -0,0 +1,133 @@
+#include "wake_budget.h"
+
+#include <string.h>
+
+void budget_statsBegin(WakeStats &st, bool watchdogReset) {
+  if (st.magic != WAKE_STATS_MAGIC || st.stage > WAKE_STAGES) {
+    memset(&st, 0, sizeof(st));
+    st.magic = WAKE_STATS_MAGIC;
+    st.stage = WAKE_STAGES;
+    st.hungStage = WAKE_STAGES;
+    return;
+  }
+  if (watchdogReset) {
+    st.watchdogResets++;
+    if (st.stage < WAKE_STAGES) {
+      st.overruns[st.stage]++;
+      st.pendingFaults |= WAKE_FAULT(st.stage);
+    }
+    st.hungStage = st.stage;
+    if (st.hangStreak < 255) st.hangStreak++;
+  } else {
+    st.hungStage = WAKE_STAGES;
+    st.hangStreak = 0;
+  }
+  st.stage = WAKE_STAGES;
+}
+
+void budget_begin(WakeBudget &b, WakeStats &st, const WakeStageSpec *specs, uint32_t limitMs, uint32_t chargeMAs,
+                  uint32_t nowMs) {
+  memset(&b, 0, sizeof(b));
+  b.specs = specs;
+  b.stats = &st;
+  b.limitMs = limitMs;
+  b.chargeMAs = chargeMAs;
+  b.startMs = b.stageStartMs = b.radioStartMs = nowMs;
+  b.stage = WAKE_BOOT;
+  // A wake cut short by a reset reports its faults in this one
+  b.faults = st.pendingFaults;
+  st.stage = WAKE_BOOT;
+}
+
+static float stageMAs(const WakeBudget &b, uint32_t nowMs) {
+  return (float)(nowMs - b.stageStartMs) * (float)b.specs[b.stage].mA / 1000.0f;
+}
+
+static float radioMAs(const WakeBudget &b, uint32_t nowMs) {
+  return (float)(nowMs - b.radioStartMs) * (float)b.radioMA / 1000.0f;
+}
+
+void budget_radio(WakeBudget &b, uint16_t mA, uint32_t nowMs) {
+  b.usedMAs += radioMAs(b, nowMs);
+  b.radioMA = mA;
+  b.radioStartMs = nowMs;
+}
+
+void budget_enter(WakeBudget &b, WakeStage stage, uint32_t nowMs) {
+  b.usedMAs += stageMAs(b, nowMs);
+  b.stage = stage;
+  b.stageStartMs = nowMs;
+  b.stageFailed = false;
+  b.stats->stage = stage;
+}
+
+float budget_usedMAs(const WakeBudget &b, uint32_t nowMs) {
+  return b.usedMAs + stageMAs(b, nowMs) + radioMAs(b, nowMs);
+}
+
+static bool stageDeadlineHit(const WakeBudget &b, uint32_t nowMs) {
+  const uint32_t deadline = b.specs[b.stage].deadlineMs;
+  return deadline && nowMs - b.stageStartMs >= deadline;
+}
+
+uint32_t budget_remainingMs(const WakeBudget &b, uint32_t nowMs) {
+  const WakeStageSpec &spec = b.specs[b.stage];
+  uint32_t rem = UINT32_MAX;
+  if (spec.deadlineMs) {
+    const uint32_t el = nowMs - b.stageStartMs;
+    rem = el < spec.deadlineMs ? spec.deadlineMs - el : 0;
+  }
+  if (b.stage == WAKE_UPLINK) return rem;
+  if (b.limitMs) {
+    const uint32_t el = nowMs - b.startMs;
+    const uint32_t left = el < b.limitMs ? b.limitMs - el : 0;
+    if (left < rem) rem = left;
+  }
+  const uint32_t mA = spec.mA + b.radioMA;
+  if (b.chargeMAs && mA) {
+    const float left = (float)b.chargeMAs - budget_usedMAs(b, nowMs);
+    const uint32_t ms = left > 0.0f ? (uint32_t)(left * 1000.0f / (float)mA) : 0;
+    if (ms < rem) rem = ms;
+  }
+  return rem;
+}
+
+static void fault(WakeBudget &b) {
+  b.faults |= WAKE_FAULT(b.stage);
+  b.stats->pendingFaults |= WAKE_FAULT(b.stage);
+  b.stageFailed = true;
+}
+
+bool budget_ok(WakeBudget &b, uint32_t nowMs) {
+  if (b.stageFailed) return false;
+  if (budget_remainingMs(b, nowMs) > 0) return true;
+  if (stageDeadlineHit(b, nowMs)) {
+    b.stats->overruns[b.stage]++;
+  } else if (!b.cut) {
+    b.cut = true;
+    b.stats->budgetCuts++;
+  }
+  fault(b);
+  return false;
+}
+
+bool budget_canStart(WakeBudget &b, WakeStage stage, uint32_t minMs, uint32_t nowMs) {
+  budget_enter(b, stage, nowMs);
+  if (budget_remainingMs(b, nowMs) >= minMs) return true;
+  b.stats->skipped++;
+  fault(b);
+  return false;
+}
+
+void budget_end(WakeBudget &b, uint32_t nowMs) {
+  b.usedMAs += stageMAs(b, nowMs) + radioMAs(b, nowMs);
+  b.stageStartMs = b.radioStartMs = nowMs;
+  b.stats->pendingFaults = 0;
+  b.stats->stage = WAKE_STAGES;
+  b.stats->hungStage = WAKE_STAGES;
+  b.stats->hangStreak = 0;
+}
+
+WakeStage budget_repeatedHang(const WakeStats &st) {
+  return st.hangStreak >= 2 ? (WakeStage)st.hungStage : WAKE_STAGES;
+}
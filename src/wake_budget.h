@@ -0,0 +1,103 @@
+// Per-wake time/charge budget with per-stage deadlines
+// Portable (no Arduino dependencies) so budgets can be simulated on the host.
+//
+// A wake walks through stages (Wi-Fi, SNTP, each sensor, uplink). Every stage
+// has a deadline and an assumed current draw, and the wake as a whole has a
+// time limit and a charge budget (mA*s) estimated from those currents. The
+// radio is charged separately, for as long as it is actually on, whichever
+// stage that spans (Wi-Fi associating during the sensor reads, or left up
+// after an abandoned Wi-Fi stage). Work
+// inside a stage polls budget_ok() and gives up once it returns false; stages
+// with a known minimum length ask budget_canStart() first and are skipped when
+// the budget cannot cover them. Either way the stage's fault bit is set for
+// the record and the event is counted. The uplink stage is exempt from the
+// wake limit (not its own deadline) so a partial record still goes out.
+//
+// Counters live in RTC memory together with the stage in progress, so a reset
+// by the task watchdog is attributed to the stage that hung.
+#pragma once
+
+#include <stdint.h>
+
+enum WakeStage : uint8_t {
+  WAKE_BOOT,
+  WAKE_WIFI,
+  WAKE_SNTP,
+  WAKE_TEMP,
+  WAKE_WEIGHT,
+  WAKE_AUDIO,
+  WAKE_UPLINK,
+  WAKE_STAGES,
+};
+
+#define WAKE_FAULT(stage) ((uint8_t)(1U << (stage)))
+#define WAKE_STATS_MAGIC 0x57414B45UL  // "WAKE"
+
+struct WakeStageSpec {
+  uint32_t deadlineMs;  // 0: no stage deadline
+  uint16_t mA;          // assumed average draw, radio excluded
+};
+
+// Kept in RTC memory across deep sleep and watchdog resets
+struct WakeStats {
+  uint32_t magic;
+  uint16_t overruns[WAKE_STAGES];  // stage deadline hit or watchdog reset in it
+  uint16_t skipped;                // stages not started for lack of budget
+  uint16_t budgetCuts;             // wakes that ran out of time or charge
+  uint16_t watchdogResets;
+  uint8_t stage;                   // stage in progress, WAKE_STAGES when idle
+  uint8_t pendingFaults;           // faults of a wake ended by a reset
+  uint8_t hungStage;               // stage that hung the last wake, WAKE_STAGES if none
+  uint8_t hangStreak;              // wakes in a row ended by the watchdog
+};
+
+struct WakeBudget {
+  const WakeStageSpec *specs;
+  WakeStats *stats;
+  uint32_t limitMs;
+  uint32_t chargeMAs;
+  uint32_t startMs;
+  uint32_t stageStartMs;
+  uint32_t radioStartMs;
+  float usedMAs;     // charge of completed stages and radio intervals
+  uint16_t radioMA;  // extra draw while the radio is on, 0 when off
+  uint8_t stage;
+  uint8_t faults;
+  bool stageFailed;
+  bool cut;
+};
+
+// Once per boot: validates the counters and, after a watchdog reset, charges
+// the overrun to the stage that was running and notes it as hung
+void budget_statsBegin(WakeStats &st, bool watchdogReset);
+
+// Start a wake (or a gateway cycle). limitMs/chargeMAs of 0 mean unlimited.
+void budget_begin(WakeBudget &b, WakeStats &st, const WakeStageSpec *specs, uint32_t limitMs, uint32_t chargeMAs,
+                  uint32_t nowMs);
+
+// Move on to a stage
+void budget_enter(WakeBudget &b, WakeStage stage, uint32_t nowMs);
+
+// Still within the stage deadline and the wake budget? Counts and flags the
+// first failure; stays false for the rest of the stage.
+bool budget_ok(WakeBudget &b, uint32_t nowMs);
+
+// Enter the stage if the budget covers minMs of it; otherwise flag it skipped
+bool budget_canStart(WakeBudget &b, WakeStage stage, uint32_t minMs, uint32_t nowMs);
+
+// Radio switched on (mA: its draw on top of the stage's) or off (0)
+void budget_radio(WakeBudget &b, uint16_t mA, uint32_t nowMs);
+
+// Time the current stage may still run (UINT32_MAX when unlimited)
+uint32_t budget_remainingMs(const WakeBudget &b, uint32_t nowMs);
+
+// Charge used so far, including the running stage and radio
+float budget_usedMAs(const WakeBudget &b, uint32_t nowMs);
+
+// Close the wake: faults are cleared from the pending set, stage goes idle
+// and the hang streak ends
+void budget_end(WakeBudget &b, uint32_t nowMs);
+
+// Stage that hung the last two wakes in a row (a retry after the watchdog
+// reset hung as well), else WAKE_STAGES
+WakeStage budget_repeatedHang(const WakeStats &st);
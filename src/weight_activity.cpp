@@ -0,0 +1,154 @@
+#include "weight_activity.h"
+
+#include <math.h>
+#include <string.h>
+
+const float kActivityBinHz[ACTIVITY_BINS] = {0.5f, 1.0f, 2.0f, 3.0f, 5.0f, 8.0f, 12.0f, 20.0f};
+
+static const float kPi = 3.14159265f;
+
+void activity_begin(ActivityState &s) {
+  memset(&s, 0, sizeof(s));
+}
+
+// Detrend, window and Goertzel one full block. Single precision: the S3's
+// FPU has no double support, and 256 detrended samples need none.
+static void processBlock(ActivityState &s) {
+  const int n = s.blockCount;
+  if (n < 2 || s.lastMs == s.blockStartMs) return;
+  const float fs = (float)(n - 1) * 1000.0f / (float)(s.lastMs - s.blockStartMs);
+
+  // Least-squares line through the block (relative to its first sample)
+  const float xm = 0.5f * (float)(n - 1);
+  float ym = 0.0f;
+  for (int i = 0; i < n; ++i) ym += (float)(s.block[i] - s.block[0]);
+  ym /= (float)n;
+  float sxy = 0.0f, sxx = 0.0f;
+  for (int i = 0; i < n; ++i) {
+    const float dx = (float)i - xm;
+    sxy += dx * ((float)(s.block[i] - s.block[0]) - ym);
+    sxx += dx * dx;
+  }
+  const float slope = sxy / sxx;
+
+  float coeff[ACTIVITY_BINS], s1[ACTIVITY_BINS] = {0}, s2[ACTIVITY_BINS] = {0};
+  for (int b = 0; b < ACTIVITY_BINS; ++b) coeff[b] = 2.0f * cosf(2.0f * kPi * kActivityBinHz[b] / fs);
+  float wsum = 0.0f;
+  for (int i = 0; i < n; ++i) {
+    const float w = 0.5f - 0.5f * cosf(2.0f * kPi * (float)i / (float)(n - 1));
+    const float v = ((float)(s.block[i] - s.block[0]) - ym - slope * ((float)i - xm)) * w;
+    wsum += w;
+    for (int b = 0; b < ACTIVITY_BINS; ++b) {
+      const float t = v + coeff[b] * s1[b] - s2[b];
+      s2[b] = s1[b];
+      s1[b] = t;
+    }
+  }
+  for (int b = 0; b < ACTIVITY_BINS; ++b) {
+    if (kActivityBinHz[b] >= ACTIVITY_MAX_BIN_FRAC * fs) continue;  // too close to Nyquist
+    const float pw = s1[b] * s1[b] + s2[b] * s2[b] - coeff[b] * s1[b] * s2[b];
+    // A sinusoid of amplitude A at the bin gives |X| = A * sum(w) / 2
+    s.power[b] += 4.0f * pw / (wsum * wsum);
+    s.powerBlocks[b]++;
+  }
+}
+
+// Robust sd of the window difference: mean of |diff| clamped at 3 sd (steps
+// and outliers barely move it), times sqrt(pi/2) for Gaussian noise
+static float diffSd(const ActivityState &s) {
+  return s.devSum / (float)s.devCount * 1.2533141f;
+}
+
+float activity_stepThreshold(const ActivityState &s) {
+  if (s.devCount < 4 * ACTIVITY_STEP_WIN) return 0.0f;
+  const float thr = ACTIVITY_STEP_SIGMA * diffSd(s);
+  return thr > ACTIVITY_STEP_MIN ? thr : (float)ACTIVITY_STEP_MIN;
+}
+
+static void countStep(ActivityState &s) {
+  if (s.stepSign > 0) s.returns++;
+  if (s.stepSign < 0) s.departures++;
+  s.stepSign = 0;
+}
+
+static void addStep(ActivityState &s, int32_t raw) {
+  s.hist[s.histPos] = raw;
+  s.histPos = (uint16_t)((s.histPos + 1) % (2 * ACTIVITY_STEP_WIN));
+  if (s.histCount < 2 * ACTIVITY_STEP_WIN) {
+    s.histCount++;
+    return;
+  }
+  // histPos is now the oldest sample
+  int64_t older = 0, recent = 0;
+  for (int i = 0; i < ACTIVITY_STEP_WIN; ++i) {
+    older += s.hist[(s.histPos + i) % (2 * ACTIVITY_STEP_WIN)];
+    recent += s.hist[(s.histPos + ACTIVITY_STEP_WIN + i) % (2 * ACTIVITY_STEP_WIN)];
+  }
+  const float diff = (float)(recent - older) / (float)ACTIVITY_STEP_WIN;
+  const float thr = activity_stepThreshold(s);
+  // The spread takes in vibration and drift as well, so neither passes for a
+  // step; samples inside a step are left out of it
+  if (!s.stepSign) {
+    const float cap = s.devCount < 4 * ACTIVITY_STEP_WIN ? fabsf(diff) : 3.0f * diffSd(s);
+    s.devSum += fabsf(diff) < cap ? fabsf(diff) : cap;
+    s.devCount++;
+  }
+  if (thr <= 0.0f) return;
+  // A step rises through the threshold as it enters the recent window and
+  // falls back as it moves into the older one: count it once, on the way down
+  const int8_t sign = diff > 0.0f ? 1 : -1;
+  if (s.stepSign && (fabsf(diff) < 0.5f * thr || sign != s.stepSign)) countStep(s);
+  if (!s.stepSign && fabsf(diff) > thr) s.stepSign = sign;
+}
+
+void activity_add(ActivityState &s, int32_t raw, uint32_t tMs) {
+  if (!s.samples) {
+    s.firstMs = tMs;
+    s.shift = raw;
+  }
+  s.samples++;
+  s.lastMs = tMs;
+  // Welford in single precision on the offset from the first sample: the raw
+  // 24-bit reading would leave the float mean too few bits for the spread
+  const float x = (float)(raw - s.shift);
+  const float d = x - s.mean;
+  s.mean += d / (float)s.samples;
+  s.m2 += d * (x - s.mean);
+
+  if (!s.blockCount) s.blockStartMs = tMs;
+  s.block[s.blockCount++] = raw;
+  if (s.blockCount == ACTIVITY_BLOCK) {
+    processBlock(s);
+    s.blockCount = 0;
+  }
+  addStep(s, raw);
+}
+
+void activity_gap(ActivityState &s) {
+  s.gaps++;
+  s.blockCount = 0;
+  s.histCount = 0;
+  s.histPos = 0;
+  s.stepSign = 0;  // a step straddling the gap cannot be told from the gap
+}
+
+void activity_finish(const ActivityState &s, ActivityResult &out) {
+  memset(&out, 0, sizeof(out));
+  out.samples = s.samples;
+  out.gaps = s.gaps;
+  if (s.samples > 1 && s.lastMs != s.firstMs) {
+    out.rateSps = (float)(s.samples - 1) * 1000.0f / (float)(s.lastMs - s.firstMs);
+  }
+  out.mean = (float)s.shift + s.mean;
+  out.sd = s.samples > 1 ? sqrtf(s.m2 / (float)(s.samples - 1)) : 0.0f;
+  for (int b = 0; b < ACTIVITY_BINS; ++b) {
+    out.amp[b] = s.powerBlocks[b] ? sqrtf(s.power[b] / (float)s.powerBlocks[b]) : 0.0f;
+  }
+  out.stepThreshold = activity_stepThreshold(s);
+  out.diffSd = s.devCount ? diffSd(s) : 0.0f;
+  out.departures = s.departures;
+  out.returns = s.returns;
+  // A step still in progress at the end
+  if (s.stepSign > 0) out.returns++;
+  if (s.stepSign < 0) out.departures++;
+}
@@ -0,0 +1,88 @@
+// Load-cell activity metrics from an HX711 stream sampled during the audio capture
+// Portable (no Arduino dependencies) so it can be checked on the host.
+//
+// Foragers leaving and landing make the hive weight fluctuate over seconds,
+// which the once-per-wake weight average throws away. Samples (~80 SPS) are
+// folded in as they arrive, at fixed memory cost:
+//  - mean and variance of the raw counts over the capture;
+//  - a low-frequency spectrum: each block of ACTIVITY_BLOCK samples is
+//    detrended, Hann-windowed and run through Goertzel filters at the
+//    ACTIVITY_BINS frequencies below, averaging power over blocks;
+//  - step counts: the mean of the last ACTIVITY_STEP_WIN samples against the
+//    mean of the ACTIVITY_STEP_WIN before them. A difference beyond
+//    ACTIVITY_STEP_SIGMA times its own robust sd over the capture is one
+//    step; a rise is a return (load added), a drop a departure. The first
+//    6 * ACTIVITY_STEP_WIN samples only fill the windows and train the sd.
+// The sample rate is measured from the timestamps per block, so a board with
+// the HX711 wired for 10 SPS still works: bins at or above
+// ACTIVITY_MAX_BIN_FRAC of the rate stay empty, and steps must then be
+// further apart to be told apart (2 * ACTIVITY_STEP_WIN samples).
+#pragma once
+
+#include <stdint.h>
+
+#ifndef ACTIVITY_BLOCK
+#define ACTIVITY_BLOCK 256  // 3.2 s at 80 SPS: ~0.3 Hz resolution
+#endif
+#define ACTIVITY_BINS 8     // 0.5, 1, 2, 3, 5, 8, 12 and 20 Hz
+#define ACTIVITY_MAX_BIN_FRAC 0.45f  // of the sample rate (Nyquist with margin)
+#ifndef ACTIVITY_STEP_WIN
+#define ACTIVITY_STEP_WIN 8  // 100 ms at 80 SPS
+#endif
+#ifndef ACTIVITY_STEP_SIGMA
+#define ACTIVITY_STEP_SIGMA 5.0f
+#endif
+#ifndef ACTIVITY_STEP_MIN
+#define ACTIVITY_STEP_MIN 0  // optional floor on the step size, in counts
+#endif
+
+extern const float kActivityBinHz[ACTIVITY_BINS];
+
+struct ActivityState {
+  // Whole capture
+  uint32_t samples;
+  uint32_t gaps;
+  uint32_t firstMs, lastMs;
+  int32_t shift;  // first sample: mean is kept relative to it
+  float mean, m2;
+  // Spectrum: current block and per-bin power sums
+  int32_t block[ACTIVITY_BLOCK];
+  uint32_t blockStartMs;
+  uint16_t blockCount;
+  float power[ACTIVITY_BINS];
+  uint16_t powerBlocks[ACTIVITY_BINS];
+  // Steps: the last 2 * ACTIVITY_STEP_WIN samples and the difference's spread
+  int32_t hist[2 * ACTIVITY_STEP_WIN];
+  uint16_t histCount;
+  uint16_t histPos;
+  float devSum;
+  uint32_t devCount;
+  int8_t stepSign;  // step in progress: +1 rise, -1 drop, 0 none
+  uint16_t departures, returns;
+};
+
+struct ActivityResult {
+  uint32_t samples;
+  uint32_t gaps;          // timeouts / lost samples while streaming
+  float rateSps;          // measured sample rate
+  float mean;             // raw counts
+  float sd;               // standard deviation (counts)
+  float amp[ACTIVITY_BINS];  // RMS-averaged sinusoid amplitude per bin (counts), 0 if unmeasured
+  float diffSd;           // spread of the step detector's window difference (counts)
+  float stepThreshold;    // step size needed to count (counts)
+  uint16_t departures;
+  uint16_t returns;
+};
+
+void activity_begin(ActivityState &s);
+
+// One conversion, with its time in ms
+void activity_add(ActivityState &s, int32_t raw, uint32_t tMs);
+
+// Samples were missed: the block and step history restart after the gap
+void activity_gap(ActivityState &s);
+
+// Current step threshold (counts); 0 until enough samples were seen
+float activity_stepThreshold(const ActivityState &s);
+
+void activity_finish(const ActivityState &s, ActivityResult &out);
@@ -0,0 +1,127 @@
+// Host check of the streaming band statistics (src/audio_stats.h)
+//
+// Build:  g++ -std=c++17 -O2 -Isrc tools/audio_stats_check.cpp src/audio_stats.cpp -o audio_stats_check
+// Usage:  audio_stats_check [frames=234] [seed=1]
+//
+// Feeds known sequences through BandStatAccumulator and compares the result
+// with exact values from the stored, sorted sequence: P-squared p10/p50/p90 by
+// the rank they land on, which must be within three standard errors of a
+// sample quantile (3 * sqrt(p(1-p)/frames), plus one frame; about 6 % of the
+// ranks for the median of a 60 s capture's 234 frames), and the Welford mean,
+// variance and max to float precision, including on a large offset where a
+// naive sum-of-squares variance cancels. Fewer than five samples must give
+// exact quantiles. Exits non-zero on any miss.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "audio_stats.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)   \
+  do {                     \
+    if (!(cond)) {         \
+      printf("  FAIL: ");  \
+      printf(__VA_ARGS__); \
+      printf("\n");        \
+      failures++;          \
+    }                      \
+  } while (0)
+
+// Distance from p to the span of ranks v occupies in the sorted sequence
+// (ties, as in silence or float-quantized input, cover a range of ranks)
+static double rankError(const std::vector<float> &sorted, float v, double p) {
+  const double n = (double)sorted.size();
+  const double lo = (double)(std::lower_bound(sorted.begin(), sorted.end(), v) - sorted.begin()) / n;
+  const double hi = (double)(std::upper_bound(sorted.begin(), sorted.end(), v) - sorted.begin()) / n;
+  return p < lo ? lo - p : (p > hi ? p - hi : 0.0);
+}
+
+static void check(const char *name, const std::vector<float> &xs) {
+  BandStatAccumulator acc;
+  acc.reset();
+  for (float x : xs) acc.add(x);
+  AudioBandStats st;
+  acc.finish(st);
+
+  std::vector<float> sorted(xs);
+  std::sort(sorted.begin(), sorted.end());
+  double mean = 0.0;
+  for (float x : xs) mean += x;
+  mean /= (double)xs.size();
+  double m2 = 0.0;
+  for (float x : xs) m2 += ((double)x - mean) * ((double)x - mean);
+  const double var = xs.size() > 1 ? m2 / (double)(xs.size() - 1) : 0.0;
+
+  const float est[3] = {st.p10, st.p50, st.p90};
+  const double ps[3] = {0.10, 0.50, 0.90};
+  double worst = 0.0;
+  for (int i = 0; i < 3; ++i) {
+    const double err = rankError(sorted, est[i], ps[i]);
+    const double tol = 3.0 * sqrt(ps[i] * (1.0 - ps[i]) / (double)xs.size()) + 1.0 / (double)xs.size();
+    if (err > worst) worst = err;
+    CHECK(err <= tol, "%s: p%.0f %.3f is %.3f off in rank", name, ps[i] * 100.0, est[i], err);
+  }
+  printf("%-26s %5zu frames: p10/p50/p90 %.3f/%.3f/%.3f (worst rank error %.3f), mean %.4f var %.4f\n", name,
+         xs.size(), st.p10, st.p50, st.p90, worst, st.mean, st.variance);
+
+  CHECK(st.max == sorted.back(), "%s: max %.4f, expected %.4f", name, st.max, sorted.back());
+  CHECK(fabs(st.mean - mean) <= 1e-6 * (fabs(mean) + 1.0), "%s: mean %.6f, expected %.6f", name, st.mean, mean);
+  CHECK(fabs(st.variance - var) <= 1e-4 * var + 1e-9, "%s: variance %.6f, expected %.6f", name, st.variance, var);
+}
+
+// Fewer than five samples: value() falls back to the exact order statistic
+static void checkFew() {
+  const float xs[4] = {3.0f, 1.0f, 4.0f, 2.0f};
+  for (uint32_t n = 1; n <= 4; ++n) {
+    std::vector<float> sorted(xs, xs + n);
+    std::sort(sorted.begin(), sorted.end());
+    P2Quantile q;
+    q.init(0.5f);
+    for (uint32_t i = 0; i < n; ++i) q.add(xs[i]);
+    const float want = sorted[(uint32_t)(0.5f * (float)(n - 1) + 0.5f)];
+    CHECK(q.value() == want, "%u samples: median %.1f, expected %.1f", n, q.value(), want);
+  }
+  P2Quantile empty;
+  empty.init(0.5f);
+  CHECK(empty.value() == 0.0f && empty.count() == 0, "empty estimator not zero");
+}
+
+int main(int argc, char **argv) {
+  const int frames = argc > 1 ? atoi(argv[1]) : 234;
+  std::mt19937 rng(argc > 2 ? (unsigned)atoi(argv[2]) : 1);
+  std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+  std::normal_distribution<float> gauss(0.0f, 1.0f);
+  std::vector<float> xs(frames);
+
+  // 1..N shuffled: the exact median is (N + 1) / 2
+  for (int i = 0; i < frames; ++i) xs[i] = (float)(i + 1);
+  std::shuffle(xs.begin(), xs.end(), rng);
+  check("1..N shuffled", xs);
+  // Band magnitude: log-normal, as the FFT band averages are
+  for (float &x : xs) x = expf(0.8f * gauss(rng));
+  check("log-normal", xs);
+  // Colony hum that swells and fades every few seconds, plus noise
+  for (int i = 0; i < frames; ++i) xs[i] = 2.0f + 1.5f * sinf(i * 0.2f) + 0.3f * uni(rng);
+  check("swelling hum", xs);
+  // Large offset, tiny spread: Welford must not cancel
+  for (float &x : xs) x = 1000.0f + 0.1f * gauss(rng);
+  check("offset 1000, sd 0.1", xs);
+  // Monotonic input: every sample extends the range past the markers
+  for (int i = 0; i < frames; ++i) xs[i] = (float)i;
+  check("ascending", xs);
+  for (int i = 0; i < frames; ++i) xs[i] = (float)(frames - i);
+  check("descending", xs);
+  // Silence: every statistic is the constant, variance zero
+  std::fill(xs.begin(), xs.end(), 0.25f);
+  check("constant", xs);
+  checkFew();
+
+  printf("%s\n", failures ? "FAIL" : "OK");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,261 @@
+// Host simulation of the hourly/daily rollup engine (src/rollup.h)
+//
+// Build:  g++ -std=c++17 -O2 -Isrc tools/rollup_sim.cpp src/rollup.cpp -o rollup_sim
+// Usage:  rollup_sim [days=120]
+//
+// Feeds months of 5-minute wake records (weight every wake, temperature every
+// 15 min, audio hourly; missed wakes, multi-hour outages, failed sensor reads,
+// a calibration change) through the engine and takes closed buckets the way
+// the firmware does. Scenarios:
+// 1. Clean clock: every taken bucket matches a brute-force aggregate of its
+//    records, every non-empty hour and day is taken exactly once, nothing lost.
+// 2. Buckets taken only every 8 hours: the hour ring overwrites, and every
+//    record is either in a taken bucket or counted as lost.
+// 3. Clock jumps (3 days ahead and back, a 2 h step back, small back-steps):
+//    the same accounting holds, and after the last jump buckets match again.
+// Exits non-zero on any mismatch.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include "rollup.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)     \
+  do {                       \
+    if (!(cond)) {           \
+      printf("  FAIL: ");    \
+      printf(__VA_ARGS__);   \
+      printf("\n");          \
+      failures++;            \
+    }                        \
+  } while (0)
+
+static const uint32_t kStartS = 1767225600UL;  // 2026-01-01 00:00 UTC
+static const uint32_t kWakeS = 300;
+
+// Brute-force aggregate with exact sums
+struct RefStat {
+  int32_t min = 0, max = 0;
+  double sum = 0.0;
+  uint32_t count = 0;
+  void add(int32_t v) {
+    if (!count || v < min) min = v;
+    if (!count || v > max) max = v;
+    sum += v;
+    count++;
+  }
+};
+
+struct RefBucket {
+  uint32_t records = 0;
+  bool units = false;
+  uint32_t firstS = 0, lastS = 0;
+  int32_t first = 0, last = 0;
+  RefStat temp, weight, battery, bands[ROLLUP_BANDS];
+};
+
+typedef std::map<uint32_t, RefBucket> RefMap;
+
+static void refAdd(RefMap &m, RollupKind kind, const RollupSample &r) {
+  RefBucket &b = m[rollup_bucketStart(kind, r.timestamp)];
+  b.records++;
+  if (r.hasTemp) b.temp.add(r.tempCx100);
+  if (r.hasBattery) b.battery.add(r.batteryMv);
+  if (r.hasBands) {
+    for (int i = 0; i < ROLLUP_BANDS; ++i) b.bands[i].add(r.bandsCdB[i]);
+  }
+  if (r.hasWeight) {
+    if (b.weight.count && b.units != r.weightUnits) b.weight = RefStat();
+    if (!b.weight.count) {
+      b.units = r.weightUnits;
+      b.first = b.last = r.weight;
+      b.firstS = b.lastS = r.timestamp;
+    } else if (r.timestamp < b.firstS) {
+      b.first = r.weight;
+      b.firstS = r.timestamp;
+    } else if (r.timestamp >= b.lastS) {
+      b.last = r.weight;
+      b.lastS = r.timestamp;
+    }
+    b.weight.add(r.weight);
+  }
+}
+
+static bool statMatches(const RollupStat &s, const RefStat &r) {
+  if (s.count != r.count) return false;
+  if (!r.count) return true;
+  const double mean = r.sum / r.count;
+  return s.min == r.min && s.max == r.max && fabs(s.mean - mean) <= 1e-4 * fabs(mean) + 0.01;
+}
+
+static bool bucketMatches(const RollupBucket &b, const RefBucket &r) {
+  if (b.records != r.records || !statMatches(b.tempCx100, r.temp) || !statMatches(b.weight, r.weight) ||
+      !statMatches(b.batteryMv, r.battery)) {
+    return false;
+  }
+  for (int i = 0; i < ROLLUP_BANDS; ++i) {
+    if (!statMatches(b.bandsCdB[i], r.bands[i])) return false;
+  }
+  if (!r.weight.count) return true;
+  return b.weightFirst == r.first && b.weightLast == r.last && ((b.flags & ROLLUP_F_UNITS) != 0) == r.units;
+}
+
+// Synthetic hive: daily temperature cycle, nectar flow by day and foraging
+// dips by midday, slow battery drain, audio louder in daylight
+struct Hive {
+  std::mt19937 rng{7};
+  std::normal_distribution<double> noise{0.0, 1.0};
+  uint32_t wake = 0;
+
+  RollupSample sample(uint32_t trueS, uint32_t stampS, bool units) {
+    RollupSample r;
+    memset(&r, 0, sizeof(r));
+    r.timestamp = stampS;
+    const double day = fmod(trueS / 86400.0, 1.0);
+    const double sun = sin(2.0 * M_PI * (day - 0.25));
+    r.hasTemp = (wake % 3) == 0 && noise(rng) > -2.0;  // ~2 % failed reads
+    r.tempCx100 = (int16_t)lround(100.0 * (18.0 + 8.0 * sun + 0.3 * noise(rng)));
+    r.hasWeight = noise(rng) > -2.3;
+    r.weightUnits = units;
+    const double kg = 42.0 + 0.3 * (trueS - kStartS) / 86400.0 - 1.2 * fmax(0.0, sun) + 0.02 * noise(rng);
+    r.weight = units ? (int32_t)lround(kg * 100.0) : (int32_t)lround(kg * 21000.0);
+    r.hasBattery = true;
+    r.batteryMv = (uint16_t)lround(4150.0 - 0.5 * (trueS - kStartS) / 3600.0 + 5.0 * noise(rng));
+    r.hasBands = (wake % 12) == 0;
+    for (int i = 0; i < ROLLUP_BANDS; ++i) {
+      r.bandsCdB[i] = (uint16_t)lround(100.0 * (40.0 + 2.0 * i + 10.0 * fmax(0.0, sun) + noise(rng)));
+    }
+    wake++;
+    return r;
+  }
+};
+
+struct Totals {
+  uint64_t records[ROLLUP_KINDS] = {0, 0};
+  uint64_t buckets[ROLLUP_KINDS] = {0, 0};
+};
+
+// Take closed buckets; optionally check them against the reference
+static void take(RollupState &s, uint32_t nowS, RefMap *ref, std::map<uint32_t, int> *seen, Totals &tot,
+                 uint32_t checkFromS) {
+  RollupBucket out[ROLLUP_DAYS > ROLLUP_HOURS ? ROLLUP_DAYS : ROLLUP_HOURS];
+  for (uint8_t k = 0; k < ROLLUP_KINDS; ++k) {
+    const RollupKind kind = (RollupKind)k;
+    const size_t n = rollup_take(s, kind, nowS, out, sizeof(out) / sizeof(out[0]));
+    for (size_t i = 0; i < n; ++i) {
+      const RollupBucket &b = out[i];
+      tot.records[k] += b.records;
+      tot.buckets[k]++;
+      CHECK(b.startS + rollup_periodS(kind) <= nowS, "open bucket taken");
+      if (!ref || b.startS < checkFromS) continue;
+      seen[k][b.startS]++;
+      auto it = ref[k].find(b.startS);
+      CHECK(it != ref[k].end() && bucketMatches(b, it->second), "%s bucket %lu differs from brute force",
+            k ? "day" : "hour", (unsigned long)b.startS);
+    }
+  }
+}
+
+struct Outage {
+  uint32_t atS, lenS;
+};
+
+// Clock offset steps: from atS (true time) on, stamps are true + offsetS
+struct ClockStep {
+  uint32_t atS;
+  int32_t offsetS;
+};
+
+static void runScenario(const char *name, int days, uint32_t takeEveryS, const std::vector<ClockStep> &steps) {
+  printf("%s:\n", name);
+  RollupState s;
+  memset(&s, 0, sizeof(s));
+  Hive hive;
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<int> pct(0, 99);
+  std::uniform_int_distribution<int> jitter(-20, 20);
+  const std::vector<Outage> outages = {{kStartS + 9 * 86400 + 3600, 14 * 3600}, {kStartS + 40 * 86400, 2 * 86400}};
+
+  // Reference only covers records after the last clock step (plus a day, so
+  // no bucket mixes timelines)
+  const uint32_t checkFromS =
+      steps.empty() ? 0 : rollup_bucketStart(ROLLUP_DAY, steps.back().atS + steps.back().offsetS) + 2 * 86400;
+  RefMap ref[ROLLUP_KINDS];
+  std::map<uint32_t, int> seen[ROLLUP_KINDS];
+  Totals tot;
+  uint64_t untimed = 0;
+  uint32_t lastTakeS = 0;
+  const uint32_t endS = kStartS + days * 86400;
+
+  for (uint32_t t = kStartS; t < endS; t += kWakeS) {
+    bool out = false;
+    for (const Outage &o : outages) out = out || (t >= o.atS && t < o.atS + o.lenS);
+    if (out || pct(rng) < 8) continue;  // outage or missed wake
+    int32_t offset = 0;
+    for (const ClockStep &c : steps) {
+      if (t >= c.atS) offset = c.offsetS;
+    }
+    const uint32_t trueS = t + jitter(rng) + 20;
+    const bool units = t >= kStartS + 20 * 86400 + 7 * 3600;  // calibrated mid-hour on day 20
+    // First boot before any time sync: no timestamp
+    const uint32_t stamp = t < kStartS + 1800 ? 0 : trueS + offset;
+    RollupSample r = hive.sample(trueS, stamp, units);
+    // As the firmware does: take what closed during sleep, then fold this wake in
+    if (stamp && t >= lastTakeS + takeEveryS) {
+      take(s, stamp, ref, seen, tot, checkFromS);
+      lastTakeS = t;
+    }
+    rollup_add(s, r);
+    if (!stamp) {
+      untimed++;
+    } else if (stamp >= checkFromS) {
+      refAdd(ref[ROLLUP_HOUR], ROLLUP_HOUR, r);
+      refAdd(ref[ROLLUP_DAY], ROLLUP_DAY, r);
+    }
+  }
+  // Final flush far past the last record
+  take(s, endS + 30 * 86400, ref, seen, tot, checkFromS);
+
+  const uint64_t total = hive.wake;
+  printf("  %llu records (%llu untimed), state %u bytes\n", (unsigned long long)total,
+         (unsigned long long)untimed, (unsigned)sizeof(RollupState));
+  for (uint8_t k = 0; k < ROLLUP_KINDS; ++k) {
+    printf("  %-4s: %llu buckets taken holding %llu records, %lu lost\n", k ? "day" : "hour",
+           (unsigned long long)tot.buckets[k], (unsigned long long)tot.records[k], (unsigned long)s.lost[k]);
+    // Every timed record is either reported or counted
+    CHECK(tot.records[k] + s.lost[k] == total - untimed, "%s accounting: %llu taken + %lu lost != %llu",
+          k ? "day" : "hour", (unsigned long long)tot.records[k], (unsigned long)s.lost[k],
+          (unsigned long long)(total - untimed));
+    for (const auto &kv : ref[k]) {
+      const auto it = seen[k].find(kv.first);
+      const int times = it == seen[k].end() ? 0 : it->second;
+      if (takeEveryS <= kWakeS) {
+        CHECK(times == 1, "%s bucket %lu taken %d times", k ? "day" : "hour", (unsigned long)kv.first, times);
+      }
+    }
+  }
+  CHECK(s.untimed == untimed, "untimed %lu, expected %llu", (unsigned long)s.untimed, (unsigned long long)untimed);
+  CHECK(s.clockJumps == 0 || !steps.empty(), "clock jumps detected on a clean clock");
+  if (!steps.empty()) printf("  %lu backward clock jumps handled\n", (unsigned long)s.clockJumps);
+}
+
+int main(int argc, char **argv) {
+  const int days = argc > 1 ? atoi(argv[1]) : 120;
+  runScenario("clean clock", days, kWakeS, {});
+  runScenario("buckets taken every 8 h", days, 8 * 3600, {});
+  runScenario("clock jumps", days, kWakeS,
+              {{kStartS + 5 * 86400, 3 * 86400},        // bad sync: 3 days ahead
+               {kStartS + 5 * 86400 + 36000, 0},        // corrected 10 h later
+               {kStartS + 12 * 86400, -2 * 3600},       // 2 h step back
+               {kStartS + 12 * 86400 + 7200, -2 * 3600 - 600},
+               {kStartS + 30 * 86400, -2 * 3600 - 900}});  // small back-steps: late records
+  printf("%s\n", failures ? "FAIL" : "OK");
+  return failures ? 1 : 0;
+}
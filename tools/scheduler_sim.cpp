@@ -0,0 +1,116 @@
+// Host simulation of the multi-rate wake scheduler (src/scheduler.h)
+//
+// Build:  g++ -std=c++17 -O2 -Isrc tools/scheduler_sim.cpp src/scheduler.cpp -o scheduler_sim
+// Usage:  scheduler_sim [days]
+//
+// Replays the firmware's wake loop: each timer wake runs the tasks due within
+// the tolerance window, then sleeps until the earliest deadline. The sleep
+// timer misses by a random error of up to +/-0.5 % (the RTC slow clock is
+// recalibrated while the chip is awake), and boot plus each task take time.
+// For each schedule it reports wakes per day, wakes that found nothing due,
+// runs per task, sensor-seconds and awake-seconds per day, and how early or
+// late tasks ran against their deadline. Exits non-zero if a task ran more
+// than the tolerance early or missed runs.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <random>
+
+#include "scheduler.h"
+
+struct TaskSpec {
+  const char *name;
+  uint32_t periodS;
+  double costS;  // time the task keeps the device awake
+};
+
+struct Scenario {
+  const char *name;
+  TaskSpec tasks[3];
+  uint32_t toleranceS;
+};
+
+static const double kBootS = 0.4;     // wake to first task
+static const double kUplinkS = 0.1;   // per-wake record delivery
+static const double kTimerErr = 0.005;
+
+static bool run(const Scenario &sc, int days, unsigned seed) {
+  const uint8_t n = 3;
+  uint32_t periods[n];
+  for (int i = 0; i < n; ++i) periods[i] = sc.tasks[i].periodS;
+
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> err(-kTimerErr, kTimerErr);
+
+  SchedState s;
+  memset(&s, 0, sizeof(s));
+  double t = 0.0;  // true time, s
+  const double end = days * 86400.0;
+  uint64_t wakes = 0, empty = 0, runs[n] = {0, 0, 0};
+  double sensorS = 0.0, awakeS = 0.0;
+  double early[n] = {0, 0, 0}, late[n] = {0, 0, 0};
+
+  while (t < end) {
+    const double wakeAt = t;
+    t += kBootS;
+    const uint32_t now = (uint32_t)t;
+    sched_begin(s, periods, n, now);
+    uint32_t due[n];
+    for (int i = 0; i < n; ++i) due[i] = s.dueS[i];
+    const uint32_t mask = sched_dueMask(s, now, sc.toleranceS);
+    sched_markRun(s, mask, now);
+    wakes++;
+    if (!mask) empty++;
+    for (int i = 0; i < n; ++i) {
+      if (!(mask & (1u << i))) continue;
+      runs[i]++;
+      const double d = t - (double)due[i];
+      if (-d > early[i]) early[i] = -d;
+      if (d > late[i]) late[i] = d;
+      t += sc.tasks[i].costS;
+      sensorS += sc.tasks[i].costS;
+    }
+    if (mask) t += kUplinkS;
+    awakeS += t - wakeAt;
+    const uint32_t sleepS = sched_sleepS(s, (uint32_t)t, 1);
+    // Sleep from the (floored) RTC second the firmware sees, with timer error
+    t = (double)(uint32_t)t + sleepS * (1.0 + err(rng));
+  }
+
+  bool ok = true;
+  printf("%s (tolerance %u s):\n", sc.name, (unsigned)sc.toleranceS);
+  printf("  %.1f wakes/day (%.1f with nothing due), %.0f sensor-s/day, %.0f awake-s/day\n", wakes / (double)days,
+         empty / (double)days, sensorS / days, awakeS / days);
+  for (int i = 0; i < n; ++i) {
+    const double expected = 86400.0 / sc.tasks[i].periodS;
+    const double perDay = runs[i] / (double)days;
+    printf("  %-7s every %4u s: %6.1f runs/day, up to %.1f s early, %.1f s late\n", sc.tasks[i].name,
+           (unsigned)sc.tasks[i].periodS, perDay, early[i], late[i]);
+    if (early[i] > sc.toleranceS + 1.0) {
+      printf("  FAIL: %s ran more than the tolerance early\n", sc.tasks[i].name);
+      ok = false;
+    }
+    if (perDay < expected * 0.99) {
+      printf("  FAIL: %s missed runs (expected %.1f/day)\n", sc.tasks[i].name, expected);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  const int days = argc > 1 ? atoi(argv[1]) : 7;
+  const Scenario scenarios[] = {
+      {"single rate: everything every 15 min", {{"weight", 900, 1.2}, {"temp", 900, 0.8}, {"audio", 900, 60.2}}, 30},
+      {"multi-rate, no coalescing", {{"weight", 300, 1.2}, {"temp", 900, 0.8}, {"audio", 3600, 60.2}}, 0},
+      {"multi-rate", {{"weight", 300, 1.2}, {"temp", 900, 0.8}, {"audio", 3600, 60.2}}, 30},
+      {"unaligned periods, no coalescing", {{"weight", 300, 1.2}, {"temp", 840, 0.8}, {"audio", 3600, 60.2}}, 0},
+      {"unaligned periods", {{"weight", 300, 1.2}, {"temp", 840, 0.8}, {"audio", 3600, 60.2}}, 60},
+  };
+  bool ok = true;
+  for (const Scenario &sc : scenarios) ok = run(sc, days, 1) && ok;
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
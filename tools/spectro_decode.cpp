@@ -0,0 +1,148 @@
+// Host decoder for HiveSync spectrogram streams (see src/spectro_codec.h)
+//
+// Build:  g++ -std=c++17 -O2 -Isrc tools/spectro_decode.cpp src/spectro_codec.cpp -o spectro_decode
+// Usage:  spectro_decode <input> [output.csv|output.pgm]
+//
+// <input> is either the raw binary stream or a serial log containing a
+// "SPECTRO BEGIN ... SPECTRO END" hex dump; each data line is
+// "SPECTRO <byte offset> <up to 32 bytes of hex>", and other lines are ignored. Output defaults to CSV on stdout
+// (one row per column: time in seconds, then dB per band). A .pgm output
+// renders the spectrogram as a greyscale image, low frequencies at the bottom.
+#include <stdio.h>
+#include <string.h>
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "spectro_codec.h"
+
+static bool readFile(const char *path, std::vector<uint8_t> &out) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) return false;
+  out.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+  return true;
+}
+
+static int hexNibble(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Extract the first hex dump framed by SPECTRO BEGIN/END from a serial log.
+// Only "SPECTRO <offset> <hex>" lines count: other log output interleaved with
+// the dump is skipped, and a missing, repeated or malformed data line, or a
+// total that differs from the BEGIN line, rejects the dump.
+static bool extractHexDump(const std::vector<uint8_t> &text, std::vector<uint8_t> &out) {
+  std::istringstream in(std::string(text.begin(), text.end()));
+  std::string line;
+  bool inside = false;
+  unsigned long expected = 0;
+  out.clear();
+  while (std::getline(in, line)) {
+    const size_t tag = line.find("SPECTRO ");
+    if (tag == std::string::npos) continue;
+    const char *p = line.c_str() + tag + 8;
+    if (!inside) {
+      if (sscanf(p, "BEGIN %lu bytes", &expected) == 1) inside = true;
+      continue;
+    }
+    if (strncmp(p, "END", 3) == 0) {
+      if (out.size() != expected) {
+        fprintf(stderr, "dump ends at %zu of %lu bytes\n", out.size(), expected);
+        return false;
+      }
+      return !out.empty();
+    }
+    unsigned long offset = 0;
+    int used = 0;
+    if (sscanf(p, "%lu %n", &offset, &used) != 1 || used == 0) {
+      fprintf(stderr, "malformed SPECTRO line: %s\n", line.c_str());
+      return false;
+    }
+    if (offset != out.size()) {
+      fprintf(stderr, "SPECTRO line at offset %lu, expected %zu (line lost or repeated)\n", offset, out.size());
+      return false;
+    }
+    const char *hex = p + used;
+    size_t n = 0;
+    while (hexNibble(hex[n]) >= 0) n++;
+    // Only a CR may follow; an odd, overlong or cut-off hex run is corrupt
+    const bool clean = hex[n] == '\0' || (hex[n] == '\r' && hex[n + 1] == '\0');
+    if (!clean || n == 0 || n % 2 || n > 64) {
+      fprintf(stderr, "malformed SPECTRO data at offset %lu\n", offset);
+      return false;
+    }
+    for (size_t i = 0; i < n; i += 2) out.push_back((uint8_t)((hexNibble(hex[i]) << 4) | hexNibble(hex[i + 1])));
+  }
+  return false;
+}
+
+static bool endsWith(const char *s, const char *suffix) {
+  const size_t n = strlen(s), m = strlen(suffix);
+  return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <input> [output.csv|output.pgm]\n", argv[0]);
+    return 2;
+  }
+  std::vector<uint8_t> raw, stream;
+  if (!readFile(argv[1], raw)) {
+    fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 1;
+  }
+  SpectroDecoder dec;
+  if (dec.begin(raw.data(), raw.size())) {
+    stream = raw;
+  } else if (!extractHexDump(raw, stream) || !dec.begin(stream.data(), stream.size())) {
+    fprintf(stderr, "no valid spectrogram stream in %s\n", argv[1]);
+    return 1;
+  }
+  dec.begin(stream.data(), stream.size());
+
+  const SpectroInfo info = dec.info();
+  std::vector<std::vector<uint8_t>> columns;
+  std::vector<uint8_t> col(info.bands);
+  while (dec.nextColumn(col.data())) columns.push_back(col);
+  if (columns.size() != info.columns) {
+    fprintf(stderr, "warning: decoded %zu of %u columns (stream corrupt?)\n", columns.size(), info.columns);
+  }
+  fprintf(stderr, "%u bands %u-%u Hz, %u ms/column, %zu columns, %zu bytes%s\n", info.bands, info.fLowHz,
+          info.fHighHz, info.cellMs, columns.size(), stream.size(), info.truncated ? " (truncated)" : "");
+
+  const char *outPath = argc > 2 ? argv[2] : nullptr;
+  FILE *out = outPath ? fopen(outPath, "wb") : stdout;
+  if (!out) {
+    fprintf(stderr, "cannot write %s\n", outPath);
+    return 1;
+  }
+
+  if (outPath && endsWith(outPath, ".pgm")) {
+    // One pixel per cell, scaled 2x vertically for readability
+    const int scale = 2;
+    fprintf(out, "P5\n%zu %d\n255\n", columns.size(), info.bands * scale);
+    for (int b = info.bands - 1; b >= 0; --b) {
+      for (int r = 0; r < scale; ++r) {
+        for (const auto &c : columns) fputc(c[b], out);
+      }
+    }
+  } else {
+    const float width = (float)(info.fHighHz - info.fLowHz) / (float)info.bands;
+    fprintf(out, "time_s");
+    for (int b = 0; b < info.bands; ++b) fprintf(out, ",%.0fHz", info.fLowHz + width * (b + 0.5f));
+    fprintf(out, "\n");
+    for (size_t t = 0; t < columns.size(); ++t) {
+      fprintf(out, "%.3f", (double)t * info.cellMs / 1000.0);
+      for (int b = 0; b < info.bands; ++b) fprintf(out, ",%.1f", spectro_codeToDb(columns[t][b], info));
+      fprintf(out, "\n");
+    }
+  }
+  if (out != stdout) fclose(out);
+  return 0;
+}
@@ -0,0 +1,140 @@
+// Host round-trip check for the spectrogram codec (src/spectro_codec.h)
+//
+// Build:  g++ -std=c++17 -O2 -Isrc tools/spectro_roundtrip.cpp src/spectro_codec.cpp -o spectro_roundtrip
+// Usage:  spectro_roundtrip [seed=1]
+//
+// Encodes synthetic code streams, decodes them back and requires every cell to
+// match. Streams cover a smooth hive-like spectrogram (short Rice codes), flat
+// silence, random codes, swings of 128 codes every column (the largest
+// residual: escape path), a swing after a long quiet run (escape while
+// the Rice context is at k = 0), 1 and SPECTRO_MAX_BANDS bands, and a buffer
+// too small for the capture (truncation keeps whole columns only). Also checks
+// that a damaged stream is rejected or decodes without overrunning. Reports
+// bits per cell. Exits non-zero on any mismatch.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <random>
+#include <vector>
+
+#include "spectro_codec.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)   \
+  do {                     \
+    if (!(cond)) {         \
+      printf("  FAIL: ");  \
+      printf(__VA_ARGS__); \
+      printf("\n");        \
+      failures++;          \
+    }                      \
+  } while (0)
+
+typedef uint8_t (*CodeFn)(int col, int band, std::mt19937 &rng);
+
+static uint8_t smooth(int col, int band, std::mt19937 &rng) {
+  const float buzz = 60.0f * expf(-0.5f * powf((band - 6 + 2.0f * sinf(col * 0.05f)) / 3.0f, 2.0f));
+  return (uint8_t)(80.0f + buzz + (float)(rng() % 5));
+}
+static uint8_t silence(int, int, std::mt19937 &) { return 0; }
+static uint8_t random8(int, int, std::mt19937 &rng) { return (uint8_t)rng(); }
+// Deltas wrap mod 256, so 0 <-> 255 is cheap; 0 <-> 128 is the largest residual
+static uint8_t fullSwing(int col, int band, std::mt19937 &) { return ((col + band) & 1) ? 128 : 0; }
+static uint8_t lateSwing(int col, int band, std::mt19937 &) {
+  if (col < 200) return 40;
+  return ((col + band) & 1) ? 168 : 40;
+}
+static uint8_t extremes(int col, int band, std::mt19937 &rng) {
+  // Deltas of exactly +-128/127, the zigzag limits
+  static const uint8_t kSeq[] = {0, 128, 0, 255, 127, 255, 0, 1, 129};
+  return kSeq[(col + band + (rng() & 1)) % sizeof(kSeq)];
+}
+
+static SpectroInfo makeInfo(uint8_t bands) {
+  SpectroInfo info = {};
+  info.bands = bands;
+  info.cellMs = 256;
+  info.fLowHz = 100;
+  info.fHighHz = 1000;
+  info.dbFloorX10 = -400;
+  info.dbStepX100 = 30;
+  return info;
+}
+
+// Encode columns into a buffer of the given capacity, decode and compare
+static void run(const char *name, CodeFn fn, uint8_t bands, int columns, size_t capacity, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::vector<uint8_t> codes((size_t)columns * bands);
+  for (int c = 0; c < columns; ++c) {
+    for (int b = 0; b < bands; ++b) codes[(size_t)c * bands + b] = fn(c, b, rng);
+  }
+
+  std::vector<uint8_t> buf(capacity);
+  SpectroEncoder enc;
+  const SpectroInfo info = makeInfo(bands);
+  CHECK(enc.begin(buf.data(), buf.size(), info), "%s: begin failed", name);
+  int accepted = 0;
+  for (int c = 0; c < columns; ++c) {
+    if (enc.addColumn(&codes[(size_t)c * bands])) {
+      CHECK(accepted == c, "%s: column %d accepted after a rejected one", name, c);
+      accepted++;
+    }
+  }
+  const size_t used = enc.finish();
+  CHECK(used <= capacity, "%s: %zu bytes used of %zu", name, used, capacity);
+  const bool truncated = accepted < columns;
+  printf("%-28s %2u bands, %4d/%d columns in %6zu bytes (%.2f bits/cell)%s\n", name, bands, accepted, columns, used,
+         accepted ? 8.0 * (double)(used - SPECTRO_HEADER_SIZE) / ((double)accepted * bands) : 0.0,
+         truncated ? ", truncated" : "");
+
+  SpectroDecoder dec;
+  if (!dec.begin(buf.data(), used)) {
+    CHECK(false, "%s: decoder rejected the header", name);
+    return;
+  }
+  const SpectroInfo &got = dec.info();
+  CHECK(got.bands == bands && got.columns == accepted && got.truncated == truncated && got.cellMs == info.cellMs &&
+            got.fLowHz == info.fLowHz && got.fHighHz == info.fHighHz && got.dbFloorX10 == info.dbFloorX10 &&
+            got.dbStepX100 == info.dbStepX100,
+        "%s: header mismatch", name);
+  std::vector<uint8_t> col(bands);
+  int decoded = 0, bad = 0;
+  while (dec.nextColumn(col.data())) {
+    for (int b = 0; b < bands; ++b) bad += col[b] != codes[(size_t)decoded * bands + b];
+    decoded++;
+  }
+  CHECK(decoded == accepted, "%s: decoded %d of %d columns", name, decoded, accepted);
+  CHECK(bad == 0, "%s: %d cells differ", name, bad);
+
+  // Damaged stream: flip bits in the body; decoding may stop early or give
+  // wrong codes, but must stay within the buffer and the column count
+  if (used > SPECTRO_HEADER_SIZE + 4) {
+    std::vector<uint8_t> broken(buf.begin(), buf.begin() + used);
+    for (int i = 0; i < 8; ++i) broken[SPECTRO_HEADER_SIZE + rng() % (used - SPECTRO_HEADER_SIZE)] ^= 1u << (rng() % 8);
+    int n = 0;
+    if (dec.begin(broken.data(), broken.size())) {
+      while (dec.nextColumn(col.data())) n++;
+    }
+    CHECK(n <= accepted, "%s: damaged stream decoded %d columns", name, n);
+  }
+}
+
+int main(int argc, char **argv) {
+  const unsigned seed = argc > 1 ? (unsigned)atoi(argv[1]) : 1;
+  const size_t roomy = 1 << 20;
+  run("smooth", smooth, 24, 235, roomy, seed);
+  run("silence", silence, 24, 235, roomy, seed);
+  run("random", random8, 24, 235, roomy, seed);
+  run("full swing", fullSwing, 24, 235, roomy, seed);
+  run("swing after quiet", lateSwing, 24, 400, roomy, seed);
+  run("zigzag limits", extremes, 24, 235, roomy, seed);
+  run("one band", fullSwing, 1, 500, roomy, seed);
+  run("max bands", random8, SPECTRO_MAX_BANDS, 235, roomy, seed);
+  run("truncated, smooth", smooth, 24, 235, 1024, seed);
+  run("truncated, full swing", fullSwing, 24, 235, 1024, seed);
+  run("header only", smooth, 24, 10, SPECTRO_HEADER_SIZE + 1, seed);
+  printf("%s\n", failures ? "FAIL" : "OK");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+// Host simulation of the deep-sleep clock model (src/time_model.h)
+//
+// Build:  g++ -std=c++17 -O2 -Isrc tools/time_model_sim.cpp src/time_model.cpp -o time_model_sim
+// Usage:  time_model_sim [weeks=8] [base_ppm=80] [swing_ppm=20] [threshold_ms=1000]
+//
+// Simulates 15-minute wake cycles on an RTC whose rate error is base_ppm plus a
+// daily temperature swing and a slow random walk. The device syncs (with 50 ms
+// SNTP-like jitter) only when the model's error bound passes the threshold.
+// Reports sync count and the worst actual error; exits non-zero if the actual
+// error ever exceeded the threshold or the model's own bound.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <random>
+
+#include "time_model.h"
+
+int main(int argc, char **argv) {
+  const int weeks = argc > 1 ? atoi(argv[1]) : 8;
+  const double basePpm = argc > 2 ? atof(argv[2]) : 80.0;
+  const double swingPpm = argc > 3 ? atof(argv[3]) : 20.0;
+  const uint32_t thresholdUs = (uint32_t)((argc > 4 ? atof(argv[4]) : 1000.0) * 1000.0);
+
+  const double cycleS = 15.0 * 60.0;
+  const double dayS = 86400.0;
+  const int cycles = (int)(weeks * 7 * dayS / cycleS);
+  const uint32_t syncAccUs = 50000;
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> jitter(-50000.0, 50000.0);
+  std::normal_distribution<double> walk(0.0, 0.3);
+
+  TimeModel m;
+  tm_init(m);
+  const int64_t epoch0 = 1767225600LL * 1000000LL;  // 2026-01-01
+  double trueUs = 0.0, rtcUs = 0.0, walkPpm = 0.0;
+  int syncs = 0, boundViolations = 0, thresholdViolations = 0;
+  double worstUs = 0.0, worstBoundUs = 0.0;
+
+  for (int c = 0; c < cycles; ++c) {
+    // Advance one cycle in small steps so the rate can vary within it
+    for (int k = 0; k < 15; ++k) {
+      const double dt = cycleS / 15.0 * 1e6;
+      walkPpm += walk(rng) * 0.05;
+      const double ppm = basePpm + swingPpm * sin(2.0 * M_PI * trueUs / 1e6 / dayS) + walkPpm;
+      trueUs += dt;
+      rtcUs += dt * (1.0 + ppm * 1e-6);
+    }
+    const uint64_t rtc = (uint64_t)rtcUs;
+    if (tm_needsSync(m, rtc, thresholdUs)) {
+      tm_sync(m, epoch0 + (int64_t)(trueUs + jitter(rng)), rtc, syncAccUs);
+      syncs++;
+      continue;
+    }
+    const double err = fabs((double)(tm_nowUs(m, rtc) - epoch0) - trueUs);
+    const double bound = (double)tm_errorBoundUs(m, rtc);
+    if (err > worstUs) worstUs = err;
+    if (bound > worstBoundUs) worstBoundUs = bound;
+    if (err > bound) boundViolations++;
+    if (err > thresholdUs) thresholdViolations++;
+  }
+
+  printf("%d weeks, %d wakes, RTC %.0f +/- %.0f ppm, threshold %u ms\n", weeks, cycles, basePpm, swingPpm,
+         thresholdUs / 1000);
+  printf("syncs %d (%.2f per day), learned drift %.1f ppm (unc %.1f)\n", syncs, syncs / (weeks * 7.0), m.driftPpm,
+         m.driftUncPpm);
+  printf("worst actual error %.1f ms, worst bound %.1f ms, bound violations %d, threshold violations %d\n",
+         worstUs / 1000.0, worstBoundUs / 1000.0, boundViolations, thresholdViolations);
+  return (boundViolations || thresholdViolations) ? 1 : 0;
+}
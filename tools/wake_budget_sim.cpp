@@ -0,0 +1,302 @@
+// Host simulation of the per-wake budget supervisor (src/wake_budget.h)
+//
+// Build:  g++ -std=c++17 -O2 -Isrc tools/wake_budget_sim.cpp src/wake_budget.cpp -o wake_budget_sim
+// Usage:  wake_budget_sim [days=3]
+//
+// Replays the standalone firmware's wake every 15 minutes: boot, temperature
+// and weight while Wi-Fi associates in the background, the Wi-Fi stage and
+// SNTP only when the clock wants a sync (about daily, then every wake until
+// one succeeds), Wi-Fi and BLE off, audio hourly, the record. It runs under
+// injected failures: an AP that is down for a day, a stuck HX711, a
+// microphone that stalls, and calls that block outright until the task
+// watchdog resets the chip. Stage defaults mirror src/supervisor.h; the radio
+// is charged for exactly as long as it is on. For each scenario it reports
+// awake time, estimated charge and radio time, against the firmware before
+// the supervisor, which joined Wi-Fi on every wake, kept the radio on until
+// sleep and had no deadlines (a missing AP kept it awake until it returned).
+// Checks that every wake ends within its limits with the radio off, that the
+// charge estimate stays within budget, and that overruns, skips and watchdog
+// resets are counted and reported in the next record, and that a stage
+// hanging twice in a row (the retry after the reset as well) is reported as a
+// repeated hang until a wake completes. Exits non-zero on any violation.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <random>
+
+#include "wake_budget.h"
+
+// Mirrors of the supervisor.h defaults (headless wake). Stages run at the CPU
+// draw; the radio adds kRadioMA for as long as it is on.
+static const uint32_t kLimitMs = 90000, kChargeMAs = 6000, kWdtMs = 20000;
+static const uint16_t kCpuMA = 45, kRadioMA = 85;
+static const WakeStageSpec kSpecs[WAKE_STAGES] = {
+    {0, kCpuMA},          // boot
+    {20000, kCpuMA},      // wifi
+    {5000, kCpuMA},       // sntp
+    {3000, kCpuMA},       // temp
+    {5000, kCpuMA},       // weight
+    {65000, kCpuMA},      // audio
+    {10000, kCpuMA},      // uplink
+};
+static const uint32_t kPollMs = 50;          // loop() period while waiting for an IP
+static const uint32_t kAudioMs = 60000;      // AUDIO_CAPTURE_MS
+static const uint32_t kHxTimeoutMs = 1000;   // first-conversion wait
+static const uint32_t kI2sTimeoutMs = 200;   // I2S_READ_TIMEOUT_MS
+static const uint32_t kWakeS = 15 * 60;
+
+static const char *const kNames[WAKE_STAGES] = {"boot", "wifi", "sntp", "temp", "weight", "audio", "uplink"};
+
+static int failures = 0;
+
+#define CHECK(cond, ...)   \
+  do {                     \
+    if (!(cond)) {         \
+      printf("  FAIL: ");  \
+      printf(__VA_ARGS__); \
+      printf("\n");        \
+      failures++;          \
+    }                      \
+  } while (0)
+
+struct Faults {
+  int apDownFromWake = -1, apDownWakes = 0;  // AP unreachable for this many wakes
+  int hxStuckPct = 0;                       // HX711 DOUT never goes low
+  int micStallPct = 0;                      // I2S clock stops mid-capture
+  int hangPct = 0;                          // a blocking call never returns
+};
+
+struct Totals {
+  uint64_t wakes = 0, hangs = 0, radioWakes = 0, awakeMs = 0, radioMs = 0, baselineMs = 0;
+  double mAs = 0.0, baselineMAs = 0.0;
+  uint32_t maxAwakeMs = 0;
+  uint32_t expectedOverruns[WAKE_STAGES] = {0};
+  uint32_t expectedSkips = 0;
+};
+
+// Charge of the pre-supervisor firmware's wake: it joined Wi-Fi on every wake
+// and kept the radio on until deep sleep
+static double baselineMAs(uint32_t awakeMs) {
+  return awakeMs * (kCpuMA + kRadioMA) / 1000.0;
+}
+
+// One wake. Returns false if a hang ended it by watchdog reset. syncDue
+// carries timekeeping_needsSync() across wakes: it stays set until a sync
+// succeeds.
+static bool wake(int n, bool wdtReset, WakeStats &st, const Faults &f, std::mt19937 &rng, Totals &tot,
+                 int &hungStage, bool &syncDue) {
+  std::uniform_int_distribution<int> pct(0, 99);
+  std::uniform_int_distribution<uint32_t> wifiMs(1500, 6000);
+  const bool apDown = f.apDownFromWake >= 0 && n >= f.apDownFromWake && n < f.apDownFromWake + f.apDownWakes;
+  const bool audio = n % 4 == 0;
+  const bool hang = pct(rng) < f.hangPct;
+  const int hangAt = hang ? (int)WAKE_TEMP + pct(rng) % 3 : -1;
+  if (n % 96 == 1) syncDue = true;  // the clock model wants SNTP about once a day
+
+  budget_statsBegin(st, wdtReset);
+  WakeBudget b;
+  uint32_t t = 0;
+  budget_begin(b, st, kSpecs, kLimitMs, kChargeMAs, t);
+  // The previous wake's hang shows up in this wake's record
+  if (wdtReset && hungStage >= 0) {
+    CHECK(b.faults & WAKE_FAULT(hungStage), "hang in %s not reported in the next record", kNames[hungStage]);
+  }
+  t += 350;  // boot
+
+  // Baseline without deadlines: joins Wi-Fi first, every wake; the first wake
+  // of an outage waits for the AP until it returns and the wakes in between
+  // never happen
+  const bool baseSkips = apDown && n != f.apDownFromWake;
+  uint32_t baseMs = 350 + (apDown ? (uint32_t)f.apDownWakes * kWakeS * 1000 : wifiMs(rng));
+
+  // Wi-Fi only when SNTP is due; it associates while the sensors are read
+  const bool wifi = syncDue;
+  uint32_t radioOnMs = 0;
+  if (wifi) {
+    budget_radio(b, kRadioMA, t);
+    radioOnMs = t;
+    tot.radioWakes++;
+  }
+  const uint32_t connectMs = apDown ? UINT32_MAX : wifiMs(rng);
+
+  // Sensors: each stage either completes, fails fast on its own timeout, or
+  // hangs; false means the watchdog reset the chip
+  auto sensor = [&](WakeStage stage) {
+    const uint32_t minMs = stage == WAKE_AUDIO ? kAudioMs + 2000 : 1;
+    if (!budget_canStart(b, stage, minMs, t)) {
+      tot.expectedSkips++;
+      return true;
+    }
+    if ((int)stage == hangAt) {
+      // Nothing feeds the watchdog: reset kWdtMs after the last feed
+      t += kWdtMs;
+      tot.awakeMs += t;
+      tot.mAs += budget_usedMAs(b, t);
+      if (b.radioMA) tot.radioMs += t - radioOnMs;
+      if (!baseSkips) {
+        // Unsupervised, a hang never ends; charged here like the watchdog case
+        tot.baselineMs += baseMs + kWdtMs;
+        tot.baselineMAs += baselineMAs(baseMs + kWdtMs);
+      }
+      tot.hangs++;
+      tot.expectedOverruns[stage]++;
+      hungStage = stage;
+      return false;
+    }
+    uint32_t d = 0;
+    switch (stage) {
+      case WAKE_TEMP: d = 800; break;
+      case WAKE_WEIGHT: d = pct(rng) < f.hxStuckPct ? kHxTimeoutMs : 1100; break;
+      default: {
+        std::uniform_int_distribution<uint32_t> at(0, kAudioMs);
+        d = pct(rng) < f.micStallPct ? at(rng) + kI2sTimeoutMs : kAudioMs + 150;
+        break;
+      }
+    }
+    t += d;
+    baseMs += d;
+    return true;
+  };
+  if (!sensor(WAKE_TEMP) || !sensor(WAKE_WEIGHT)) return false;
+
+  if (wifi) {
+    // loop() polls the stage while waiting for GOT_IP
+    budget_enter(b, WAKE_WIFI, t);
+    bool ip = false;
+    for (;;) {
+      if (t - radioOnMs >= connectMs) {
+        ip = true;
+        break;
+      }
+      if (!budget_ok(b, t)) break;
+      t += kPollMs;
+    }
+    if (!ip) tot.expectedOverruns[WAKE_WIFI]++;
+    if (ip && budget_canStart(b, WAKE_SNTP, 1, t)) {
+      t += 400;
+      baseMs += 400;
+      syncDue = false;
+    }
+    // Provisioning, Wi-Fi and BLE stop before the capture either way
+    budget_radio(b, 0, t);
+    tot.radioMs += t - radioOnMs;
+  } else if (n % 96 == 1) {
+    baseMs += 400;  // the baseline synced on this wake
+  }
+
+  if (audio && !sensor(WAKE_AUDIO)) return false;
+
+  // The (possibly partial) record goes out on serial, then sleep
+  budget_enter(b, WAKE_UPLINK, t);
+  t += 50;
+  baseMs += 300;  // the baseline printed with the radio still on
+  budget_end(b, t);
+
+  CHECK(t <= kLimitMs + kSpecs[WAKE_UPLINK].deadlineMs + kPollMs, "wake %d awake %lu ms", n, (unsigned long)t);
+  const float uplinkMAs = kSpecs[WAKE_UPLINK].deadlineMs * kCpuMA / 1000.0f;
+  CHECK(b.usedMAs <= kChargeMAs + uplinkMAs + 10.0f, "wake %d used %.0f mAs", n, b.usedMAs);
+  CHECK(st.pendingFaults == 0 && st.stage == WAKE_STAGES, "wake %d left state pending", n);
+  CHECK(b.radioMA == 0, "wake %d went to sleep with the radio on", n);
+
+  tot.wakes++;
+  tot.awakeMs += t;
+  tot.mAs += b.usedMAs;
+  if (t > tot.maxAwakeMs) tot.maxAwakeMs = t;
+  if (!baseSkips) {
+    tot.baselineMs += baseMs;
+    tot.baselineMAs += baselineMAs(baseMs);
+  }
+  hungStage = -1;
+  return true;
+}
+
+static void runScenario(const char *name, int days, const Faults &f) {
+  printf("%s:\n", name);
+  WakeStats st;
+  memset(&st, 0xA5, sizeof(st));  // RTC_NOINIT: garbage at power-on
+  std::mt19937 rng(3);
+  Totals tot;
+  const int wakes = days * 86400 / kWakeS;
+  bool wdt = false, syncDue = true;  // power-on: no valid clock yet
+  int hungStage = -1;
+  for (int n = 0; n < wakes; ++n) wdt = !wake(n, wdt, st, f, rng, tot, hungStage, syncDue);
+  if (wdt) budget_statsBegin(st, true);  // let the final reset be counted
+
+  const double perDay = 86400.0 / kWakeS;
+  const double n = (double)(tot.wakes + tot.hangs);
+  printf("  %llu wakes (%llu watchdog resets): %.1f s awake avg, %.1f s max, %.0f mAs avg -> %.1f mAh/day\n",
+         (unsigned long long)n, (unsigned long long)tot.hangs, tot.awakeMs / n / 1000.0, tot.maxAwakeMs / 1000.0,
+         tot.mAs / n, tot.mAs / n * perDay / 3600.0);
+  printf("  radio on %.1f wakes/day, %.0f s/day\n", tot.radioWakes / (double)days, tot.radioMs / 1000.0 / days);
+  printf("  joining Wi-Fi every wake, without deadlines: %.0f s awake per day, %.1f mAh/day\n",
+         tot.baselineMs / 1000.0 / days, tot.baselineMAs / 3600.0 / days);
+  printf("  ");
+  bool any = false;
+  for (int s = 0; s < WAKE_STAGES; ++s) {
+    if (!st.overruns[s]) continue;
+    printf("%s%s %u", any ? ", " : "overruns: ", kNames[s], st.overruns[s]);
+    any = true;
+  }
+  printf("%sskipped %u, budget cuts %u, watchdog %u\n", any ? "; " : "", st.skipped, st.budgetCuts,
+         st.watchdogResets);
+
+  for (int s = 0; s < WAKE_STAGES; ++s) {
+    CHECK(st.overruns[s] == tot.expectedOverruns[s], "%s overruns %u, expected %u", kNames[s], st.overruns[s],
+          tot.expectedOverruns[s]);
+  }
+  CHECK(st.skipped == tot.expectedSkips, "skipped %u, expected %u", st.skipped, tot.expectedSkips);
+  CHECK(st.watchdogResets == tot.hangs, "watchdog resets %u, expected %llu", st.watchdogResets,
+        (unsigned long long)tot.hangs);
+}
+
+// Retry policy: one hang is retried, a second in a row is reported
+static void checkRepeatedHang() {
+  const int before = failures;
+  WakeStats st = {};
+  WakeBudget b;
+  budget_statsBegin(st, false);
+  budget_begin(b, st, kSpecs, kLimitMs, kChargeMAs, 0);
+  budget_enter(b, WAKE_AUDIO, 1000);
+  budget_statsBegin(st, true);  // watchdog reset during audio
+  CHECK(budget_repeatedHang(st) == WAKE_STAGES, "first hang reported as repeated");
+  budget_begin(b, st, kSpecs, kLimitMs, kChargeMAs, 0);
+  budget_enter(b, WAKE_AUDIO, 1000);
+  budget_statsBegin(st, true);  // the retry hangs too
+  CHECK(budget_repeatedHang(st) == WAKE_AUDIO, "second hang in audio reported as %u", budget_repeatedHang(st));
+  budget_begin(b, st, kSpecs, kLimitMs, kChargeMAs, 0);
+  budget_end(b, 5000);  // audio skipped, wake completes
+  CHECK(budget_repeatedHang(st) == WAKE_STAGES, "repeated hang still reported after a completed wake");
+  budget_begin(b, st, kSpecs, kLimitMs, kChargeMAs, 0);
+  budget_enter(b, WAKE_WIFI, 1000);
+  budget_statsBegin(st, true);
+  budget_begin(b, st, kSpecs, kLimitMs, kChargeMAs, 0);
+  budget_enter(b, WAKE_TEMP, 1000);
+  budget_statsBegin(st, true);  // two hangs, but in different stages
+  CHECK(budget_repeatedHang(st) == WAKE_TEMP, "hang after a hang elsewhere reported as %u", budget_repeatedHang(st));
+  budget_statsBegin(st, false);  // deep sleep wake
+  CHECK(budget_repeatedHang(st) == WAKE_STAGES, "repeated hang reported after a deep sleep wake");
+  if (failures == before) printf("repeated hangs: retried once, then skipped; cleared by a completed wake\n");
+}
+
+int main(int argc, char **argv) {
+  const int days = argc > 1 ? atoi(argv[1]) : 3;
+  checkRepeatedHang();
+  Faults healthy;
+  runScenario("healthy", days, healthy);
+  Faults ap;
+  ap.apDownFromWake = 20;
+  ap.apDownWakes = 96;
+  runScenario("AP down for a day", days, ap);
+  Faults flaky;
+  flaky.hxStuckPct = 10;
+  flaky.micStallPct = 10;
+  runScenario("stuck HX711 and stalling microphone (10 % each)", days, flaky);
+  Faults hangs;
+  hangs.hangPct = 3;
+  hangs.apDownFromWake = 150;
+  hangs.apDownWakes = 12;
+  runScenario("blocking hangs (3 % of wakes) and a 3 h AP outage", days, hangs);
+  printf("%s\n", failures ? "FAIL" : "OK");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,167 @@
+// Host check of the load-cell activity metrics (src/weight_activity.h)
+//
+// Build:  g++ -std=c++17 -O2 -Isrc tools/weight_activity_sim.cpp src/weight_activity.cpp -o weight_activity_sim
+// Usage:  weight_activity_sim [seed=1]
+//
+// Streams a synthetic 60 s HX711 capture (as during the audio window) through
+// the metrics: a drifting baseline with Gaussian noise, low-frequency
+// vibration at known amplitudes, and level steps for departures and returns,
+// sampled with the 1 ms timestamp jitter of the polling task. Scenarios cover
+// 80 SPS, a board wired for 10 SPS and a stream with missed samples. Checks
+// that step counts match, that a noise-only stream counts none, that the
+// spectrum recovers the injected amplitudes when no steps are present (bins
+// near or above Nyquist empty), that the single-precision mean and sd match
+// exact ones, and reports the processing cost per sample and per block. Exits
+// non-zero on any violation.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "weight_activity.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)   \
+  do {                     \
+    if (!(cond)) {         \
+      printf("  FAIL: ");  \
+      printf(__VA_ARGS__); \
+      printf("\n");        \
+      failures++;          \
+    }                      \
+  } while (0)
+
+struct Tone {
+  float hz, amp;
+};
+
+struct Scenario {
+  const char *name;
+  float sps;
+  float noise;             // counts, per sample
+  std::vector<Tone> tones;
+  int departures, returns;
+  float stepCounts;        // step size (counts)
+  int gaps;                // timeouts (each loses ~0.2 s)
+};
+
+static ActivityState s_state;  // ~1.2 KB; static as on the device
+
+static void run(const Scenario &sc, unsigned seed) {
+  printf("%s:\n", sc.name);
+  std::mt19937 rng(seed);
+  std::normal_distribution<float> noise(0.0f, sc.noise);
+  std::uniform_int_distribution<int> jitter(0, 1);
+  const float durS = 60.0f;
+
+  // Step times after the detector's warm-up and away from the end: one per
+  // equal slot, jittered but apart by at least 1 s and by more than its two
+  // windows, departures and returns in random order
+  std::vector<std::pair<float, int>> steps;
+  const float warmupS = 6.0f * ACTIVITY_STEP_WIN / sc.sps;
+  const float apartS = fmaxf(1.0f, 2.5f * 2 * ACTIVITY_STEP_WIN / sc.sps);
+  const int nSteps = sc.departures + sc.returns;
+  const float firstS = 1.0f + warmupS, lastS = durS - 1.0f;
+  for (int i = 0; i < nSteps; ++i) steps.push_back({0.0f, i < sc.departures ? -1 : 1});
+  std::shuffle(steps.begin(), steps.end(), rng);
+  if (nSteps) {
+    const float slot = (lastS - firstS) / nSteps;
+    std::uniform_real_distribution<float> jitterS(0.0f, fmaxf(0.0f, slot - apartS));
+    for (int i = 0; i < nSteps; ++i) steps[i].first = firstS + slot * i + jitterS(rng);
+  }
+  std::uniform_real_distribution<float> when(firstS, lastS);
+  std::vector<float> gapAt;
+  while ((int)gapAt.size() < sc.gaps) {
+    const float t = when(rng);
+    bool clear = true;
+    for (auto &s : steps) clear = clear && fabsf(s.first - t) >= 0.8f;
+    if (clear) gapAt.push_back(t);
+  }
+  std::sort(gapAt.begin(), gapAt.end());
+
+  activity_begin(s_state);
+  std::vector<int32_t> raws;
+  double usTotal = 0.0, usMax = 0.0;
+  const float period = 1.0f / sc.sps;
+  size_t nextGap = 0;
+  for (float t = 0.0f; t < durS; t += period) {
+    if (nextGap < gapAt.size() && t >= gapAt[nextGap]) {
+      activity_gap(s_state);
+      t += 0.2f;
+      nextGap++;
+      continue;
+    }
+    float v = 500000.0f + 5.0f * t + noise(rng);  // baseline with drift
+    for (const Tone &tn : sc.tones) v += tn.amp * sinf(2.0f * (float)M_PI * tn.hz * t + tn.hz);
+    for (auto &s : steps) {
+      if (t >= s.first) v += s.second * sc.stepCounts;
+    }
+    const uint32_t ms = (uint32_t)(t * 1000.0f) + jitter(rng);
+    raws.push_back((int32_t)lrintf(v));
+    const auto t0 = std::chrono::steady_clock::now();
+    activity_add(s_state, raws.back(), ms);
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    usTotal += us;
+    if (us > usMax) usMax = us;
+  }
+
+  ActivityResult r;
+  activity_finish(s_state, r);
+  // Exact mean and sd of what was fed, for the single-precision Welford
+  double mean = 0.0, m2 = 0.0;
+  for (int32_t x : raws) mean += x;
+  mean /= (double)raws.size();
+  for (int32_t x : raws) m2 += (x - mean) * (x - mean);
+  const double sd = sqrt(m2 / (double)(raws.size() - 1));
+  printf("  %u samples at %.1f SPS, %u gaps; mean %.1f (exact %.1f), sd %.2f (exact %.2f), step threshold %.0f "
+         "counts\n",
+         r.samples, r.rateSps, r.gaps, r.mean, mean, r.sd, sd, r.stepThreshold);
+  printf("  departures %u (true %d), returns %u (true %d)\n  amplitude:", r.departures, sc.departures, r.returns,
+         sc.returns);
+  for (int b = 0; b < ACTIVITY_BINS; ++b) printf(" %.1fHz=%.1f", kActivityBinHz[b], r.amp[b]);
+  printf("\n  cost: %.2f us/sample avg, %.0f us worst (block)\n", usTotal / r.samples, usMax);
+
+  CHECK(r.departures == (uint16_t)sc.departures, "departures %u, expected %d", r.departures, sc.departures);
+  CHECK(r.returns == (uint16_t)sc.returns, "returns %u, expected %d", r.returns, sc.returns);
+  CHECK(fabsf(r.rateSps - sc.sps) < 0.05f * sc.sps || sc.gaps, "rate %.1f SPS, expected %.1f", r.rateSps, sc.sps);
+  CHECK(r.gaps == (uint32_t)sc.gaps, "gaps %u, expected %d", r.gaps, sc.gaps);
+  CHECK(fabs(r.mean - mean) <= 0.5, "mean %.1f, exact %.1f", r.mean, mean);
+  CHECK(fabs(r.sd - sd) <= 1e-3 * sd, "sd %.3f, exact %.3f", r.sd, sd);
+  for (int b = 0; b < ACTIVITY_BINS; ++b) {
+    const float f = kActivityBinHz[b];
+    if (f >= ACTIVITY_MAX_BIN_FRAC * sc.sps) {
+      CHECK(r.amp[b] == 0.0f, "%.1f Hz above Nyquist reads %.1f", f, r.amp[b]);
+      continue;
+    }
+    float want = 0.0f;
+    for (const Tone &tn : sc.tones) {
+      if (tn.hz == f) want = tn.amp;
+    }
+    // Steps are broadband themselves; amplitudes are only checked without them
+    if (nSteps) continue;
+    if (want > 0.0f) {
+      // Noise adds ~2.5 counts rms per bin at 80 SPS; only two blocks at 10 SPS
+      CHECK(fabsf(r.amp[b] - want) <= 0.1f * want + 0.25f * sc.noise, "%.1f Hz amplitude %.1f, injected %.1f", f,
+            r.amp[b], want);
+    } else {
+      CHECK(r.amp[b] < 0.3f * sc.noise, "%.1f Hz reads %.1f with no tone", f, r.amp[b]);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  const unsigned seed = argc > 1 ? (unsigned)atoi(argv[1]) : 1;
+  run({"80 SPS, noise only", 80.0f, 20.0f, {}, 0, 0, 0.0f, 0}, seed);
+  run({"80 SPS, vibration", 80.0f, 20.0f, {{2.0f, 15.0f}, {8.0f, 10.0f}, {20.0f, 8.0f}}, 0, 0, 0.0f, 0}, seed);
+  run({"80 SPS, traffic", 80.0f, 20.0f, {{2.0f, 15.0f}, {8.0f, 10.0f}}, 14, 11, 150.0f, 0}, seed);
+  run({"80 SPS, traffic with missed samples", 80.0f, 20.0f, {{3.0f, 12.0f}}, 9, 12, 150.0f, 4}, seed);
+  run({"10 SPS wiring, vibration", 10.0f, 20.0f, {{1.0f, 30.0f}, {3.0f, 20.0f}}, 0, 0, 0.0f, 0}, seed);
+  run({"10 SPS wiring, traffic", 10.0f, 20.0f, {{1.0f, 30.0f}}, 4, 5, 200.0f, 0}, seed);
+  printf("%s\n", failures ? "FAIL" : "OK");
+  return failures ? 1 : 0;
+}